@@ -0,0 +1,63 @@
+/**
+ * @file alt_bench.cpp
+ * Compares settled airports and latency of ALT search against plain Dijkstra on random airport pairs,
+ * for several landmark counts, and reports how long picking the landmarks takes.
+ */
+
+#include "../graph/graph.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+/**
+ * Runs every pair with one engine
+ * @return average milliseconds per query; settled is set to the average settled airports per query
+ */
+static double run(Graph& g, const vector<pair<Vertex, Vertex>>& pairs, PathAlgorithm algorithm, double& settled, vector<int>& distances) {
+    long long total = 0;
+    distances.clear();
+    auto start = Clock::now();
+    for (auto& od : pairs) {
+        auto result = g.shortestPath(od.first, od.second, algorithm);
+        total += result.settled;
+        distances.push_back(result.totalDistance);
+    }
+    double ms = chrono::duration<double, milli>(Clock::now() - start).count();
+    settled = (double) total / pairs.size();
+    return ms / pairs.size();
+}
+
+int main() {
+    Graph g("assets/airports.csv", "assets/routes.csv");
+
+    // Random pairs of airports from assets/airports.csv that have at least one outgoing route
+    vector<Vertex> airports;
+    for (Vertex v = 0; v < 15000; v++)
+        if (g.vertexExists(v) && !g.getAirport(v).getName().empty() && !g.getOutgoing(v).empty()) airports.push_back(v);
+    mt19937 rng(225);
+    uniform_int_distribution<size_t> pick(0, airports.size() - 1);
+    vector<pair<Vertex, Vertex>> pairs;
+    for (int i = 0; i < 1000; i++) pairs.push_back({airports[pick(rng)], airports[pick(rng)]});
+
+    double settled;
+    vector<int> expected, actual;
+    double dijkstraMs = run(g, pairs, PathAlgorithm::Dijkstra, settled, expected);
+    cout << "Dijkstra        : " << dijkstraMs << " ms/query, " << settled << " settled/query (" << pairs.size() << " pairs)" << endl;
+
+    for (int count : {4, 8, 16, 32}) {
+        auto start = Clock::now();
+        g.prepareLandmarks(count);
+        double prepareMs = chrono::duration<double, milli>(Clock::now() - start).count();
+
+        double altMs = run(g, pairs, PathAlgorithm::ALT, settled, actual);
+        cout << "ALT " << count << (count < 10 ? " " : "") << " landmarks: " << altMs << " ms/query, " << settled << " settled/query, "
+             << prepareMs << " ms to prepare" << (actual == expected ? "" : " (MISMATCH)") << endl;
+    }
+    return 0;
+}
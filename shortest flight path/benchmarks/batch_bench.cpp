@@ -0,0 +1,52 @@
+/**
+ * @file batch_bench.cpp
+ * Measures how batch query throughput scales with the number of pool threads, checking every batch against the
+ * single-threaded answers.
+ */
+
+#include "../graph/graph.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+int main() {
+    Graph g("assets/airports.csv", "assets/routes.csv");
+
+    vector<Vertex> airports;
+    for (Vertex v = 0; v < 15000; v++)
+        if (g.vertexExists(v) && !g.getAirport(v).getName().empty() && !g.getOutgoing(v).empty()) airports.push_back(v);
+    mt19937 rng(225);
+    uniform_int_distribution<size_t> pick(0, airports.size() - 1);
+    vector<pair<Vertex, Vertex>> queries;
+    for (int i = 0; i < 20000; i++) queries.push_back({airports[pick(rng)], airports[pick(rng)]});
+
+    unsigned maxThreads = max(1u, thread::hardware_concurrency());
+    for (auto algorithm : {PathAlgorithm::Bidirectional, PathAlgorithm::ContractionHierarchy}) {
+        g.prepare(algorithm);
+        cout << (algorithm == PathAlgorithm::Bidirectional ? "Bidirectional" : "Contraction Hierarchy") << ", " << queries.size() << " queries" << endl;
+
+        vector<int> expected;
+        for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+            ThreadPool pool(threads);
+            auto start = Clock::now();
+            auto results = g.shortestPaths(queries, algorithm, pool);
+            double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+            int mismatches = 0;
+            for (size_t i = 0; i < results.size(); i++) {
+                if (expected.size() < results.size()) expected.push_back(results[i].totalDistance);
+                mismatches += results[i].totalDistance != expected[i];
+            }
+            cout << "  threads " << threads << " : " << queries.size() / seconds << " queries/s" << (mismatches ? " (" + to_string(mismatches) + " MISMATCHES)" : "") << endl;
+            if (threads == maxThreads) break;
+            if (threads * 2 > maxThreads) threads = maxThreads / 2;
+        }
+    }
+    return 0;
+}
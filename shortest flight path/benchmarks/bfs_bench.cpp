@@ -0,0 +1,66 @@
+/**
+ * @file bfs_bench.cpp
+ * Times the direction-optimizing hopTree() from random airports on the calling thread and on pools of increasing
+ * size, against the queue-based BFS(), and checks that every run reaches the same airports at the same hop counts.
+ */
+
+#include "../graph/graph.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+int main() {
+    Graph g("assets/airports.csv", "assets/routes.csv");
+
+    vector<Vertex> sources;
+    for (Vertex v = 0; v < 15000; v++)
+        if (g.vertexExists(v) && !g.getOutgoing(v).empty()) sources.push_back(v);
+    mt19937 rng(225);
+    shuffle(sources.begin(), sources.end(), rng);
+    const size_t queries = 500;
+    sources.resize(queries);
+
+    // Queue-based traversal
+    long long visited = 0;
+    auto start = Clock::now();
+    for (Vertex source : sources) visited += g.BFS(source).size();
+    double queueMs = chrono::duration<double, milli>(Clock::now() - start).count() / queries;
+    cout << "Vertices: " << g.getVerticeCount() << " | Edges: " << g.getEdgeCount() << endl;
+    cout << "BFS()                 : " << queueMs << " ms/query, " << visited / queries << " reached/query" << endl;
+
+    // Hop trees, on the calling thread first and then on pools
+    vector<long long> expected;
+    auto run = [&](ThreadPool* pool, const string& label) {
+        long long reached = 0, hopSum = 0;
+        int mismatches = 0;
+        auto start = Clock::now();
+        for (size_t i = 0; i < queries; i++) {
+            auto tree = g.hopTree(sources[i], pool);
+            long long sum = 0;
+            for (int h : tree.hops) if (h != INT_MAX) { reached++; sum += h; }
+            if (expected.size() < queries) expected.push_back(sum);
+            mismatches += sum != expected[i];
+            hopSum += sum;
+        }
+        double ms = chrono::duration<double, milli>(Clock::now() - start).count() / queries;
+        cout << label << ms << " ms/query, " << reached / queries << " reached/query, " << (double) hopSum / reached << " hops on average"
+             << (mismatches ? " (" + to_string(mismatches) + " MISMATCHES)" : "") << endl;
+    };
+    run(nullptr, "hopTree()             : ");
+
+    unsigned maxThreads = max(1u, thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        ThreadPool pool(threads);
+        run(&pool, "hopTree(), " + to_string(threads) + " threads  : ");
+        if (threads == maxThreads) break;
+        if (threads * 2 > maxThreads) threads = maxThreads / 2;
+    }
+    return 0;
+}
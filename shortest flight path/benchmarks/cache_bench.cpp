@@ -0,0 +1,65 @@
+/**
+ * @file cache_bench.cpp
+ * Replays queries whose origins follow a Zipf distribution over a few hundred hub airports through the shortest path
+ * tree cache at several budgets, reporting latency, hit rate and evictions against bidirectional Dijkstra.
+ */
+
+#include "../graph/graph.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+int main() {
+    Graph g("assets/airports.csv", "assets/routes.csv");
+
+    // The busiest airports are the origins, the most popular ones first
+    vector<Vertex> airports;
+    for (Vertex v = 0; v < 15000; v++)
+        if (g.vertexExists(v) && !g.getAirport(v).getName().empty() && !g.getOutgoing(v).empty()) airports.push_back(v);
+    vector<Vertex> hubs = airports;
+    sort(hubs.begin(), hubs.end(), [&](Vertex a, Vertex b) { return g.getOutgoing(a).size() > g.getOutgoing(b).size(); });
+    hubs.resize(300);
+
+    mt19937 rng(225);
+    vector<double> weights;
+    for (size_t i = 0; i < hubs.size(); i++) weights.push_back(1.0 / (i + 1));
+    discrete_distribution<size_t> origin(weights.begin(), weights.end());
+    uniform_int_distribution<size_t> destination(0, airports.size() - 1);
+    vector<pair<Vertex, Vertex>> queries;
+    for (int i = 0; i < 20000; i++) queries.push_back({hubs[origin(rng)], airports[destination(rng)]});
+
+    vector<int> expected;
+    auto start = Clock::now();
+    for (auto& od : queries) expected.push_back(g.shortestPath(od.first, od.second).totalDistance);
+    double bidirectionalUs = chrono::duration<double, micro>(Clock::now() - start).count() / queries.size();
+    cout << queries.size() << " queries from " << hubs.size() << " hub origins" << endl;
+    cout << "Bidirectional : " << bidirectionalUs << " us/query" << endl;
+
+    size_t treeBytes = 2 * sizeof(int) * g.getCSR().vertexCount();
+    for (size_t trees : {16, 64, 300}) {
+        TreeCache& cache = g.getTreeCache();
+        cache.clear();
+        cache.setBudget(trees * treeBytes);
+        TreeCache::Stats before = cache.stats();
+
+        int mismatches = 0;
+        start = Clock::now();
+        for (size_t i = 0; i < queries.size(); i++)
+            mismatches += g.shortestPath(queries[i].first, queries[i].second, PathAlgorithm::CachedTree).totalDistance != expected[i];
+        double us = chrono::duration<double, micro>(Clock::now() - start).count() / queries.size();
+
+        TreeCache::Stats after = cache.stats();
+        size_t hits = after.hits - before.hits, misses = after.misses - before.misses;
+        cout << "Cache of " << trees << " trees : " << us << " us/query, "
+             << 100.0 * hits / (hits + misses) << "% hits, " << after.evictions - before.evictions << " evictions, "
+             << after.bytes / 1024 << " KiB held" << (mismatches ? " (" + to_string(mismatches) + " MISMATCHES)" : "") << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+/**
+ * @file ch_bench.cpp
+ * Measures Contraction Hierarchy preprocessing time and compares its query latency and settled airports
+ * against Dijkstra and bidirectional Dijkstra on random airport pairs.
+ */
+
+#include "../graph/graph.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+int main() {
+    Graph g("assets/airports.csv", "assets/routes.csv");
+
+    unsigned maxThreads = max(1u, thread::hardware_concurrency());
+    for (unsigned threads : {1u, maxThreads}) {
+        ThreadPool pool(threads);
+        auto start = Clock::now();
+        g.prepareContractionHierarchy(pool);
+        double ms = chrono::duration<double, milli>(Clock::now() - start).count();
+        cout << "Preprocessing (" << threads << " thread" << (threads == 1 ? "" : "s") << "): " << ms << " ms, "
+             << g.getContractionHierarchy().shortcutCount() << " shortcuts for " << g.getEdgeCount() << " routes" << endl;
+        if (maxThreads == 1) break;
+    }
+
+    vector<Vertex> airports;
+    for (Vertex v = 0; v < 15000; v++)
+        if (g.vertexExists(v) && !g.getAirport(v).getName().empty() && !g.getOutgoing(v).empty()) airports.push_back(v);
+    mt19937 rng(225);
+    uniform_int_distribution<size_t> pick(0, airports.size() - 1);
+    vector<pair<Vertex, Vertex>> pairs;
+    for (int i = 0; i < 1000; i++) pairs.push_back({airports[pick(rng)], airports[pick(rng)]});
+
+    vector<int> expected;
+    for (auto algorithm : {PathAlgorithm::Dijkstra, PathAlgorithm::Bidirectional, PathAlgorithm::ContractionHierarchy}) {
+        long long settled = 0;
+        int mismatches = 0;
+        auto start = Clock::now();
+        for (size_t i = 0; i < pairs.size(); i++) {
+            auto result = g.shortestPath(pairs[i].first, pairs[i].second, algorithm);
+            settled += result.settled;
+            if (algorithm == PathAlgorithm::Dijkstra) expected.push_back(result.totalDistance);
+            else mismatches += result.totalDistance != expected[i];
+        }
+        double ms = chrono::duration<double, milli>(Clock::now() - start).count() / pairs.size();
+        const char* name = algorithm == PathAlgorithm::Dijkstra ? "Dijkstra             " : algorithm == PathAlgorithm::Bidirectional ? "Bidirectional        " : "Contraction Hierarchy";
+        cout << name << ": " << ms << " ms/query, " << settled / (double) pairs.size() << " settled/query"
+             << (mismatches ? " (" + to_string(mismatches) + " MISMATCHES)" : "") << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+/**
+ * @file dijkstra_bench.cpp
+ * Compares per-query latency of the original scan-based dijkstra() against the heap-based
+ * shortestPathTree() on the full OpenFlights dataset, then compares point-to-point queries answered by a
+ * full shortestPathTree() against shortestPath() with early-exit Dijkstra, bidirectional Dijkstra and A*, and
+ * bidirectional queries that reuse one SearchWorkspace against ones that each start from a new one.
+ */
+
+#include "../graph/graph.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+int main() {
+    Graph g("assets/airports.csv", "assets/routes.csv");
+
+    // Collect every airport that has at least one outgoing route
+    vector<Vertex> sources;
+    for (Vertex v = 0; v < 15000; v++)
+        if (g.vertexExists(v) && !g.getOutgoing(v).empty()) sources.push_back(v);
+
+    mt19937 rng(225);
+    shuffle(sources.begin(), sources.end(), rng);
+
+    const unsigned legacyQueries = 3, heapQueries = 500;
+
+    // Original implementation
+    auto start = Clock::now();
+    for (unsigned i = 0; i < legacyQueries; i++) g.dijkstra(sources[i]);
+    double legacyMs = chrono::duration<double, milli>(Clock::now() - start).count() / legacyQueries;
+
+    // Heap-based implementation
+    start = Clock::now();
+    long long checksum = 0;
+    for (unsigned i = 0; i < heapQueries; i++) {
+        auto tree = g.shortestPathTree(sources[i % sources.size()]);
+        for (int d : tree.dist) if (d != INT_MAX) checksum += d;
+    }
+    double heapMs = chrono::duration<double, milli>(Clock::now() - start).count() / heapQueries;
+
+    cout << "Vertices: " << g.getVerticeCount() << " | Edges: " << g.getEdgeCount() << endl;
+    cout << "dijkstra()          : " << legacyMs << " ms/query (" << legacyQueries << " queries)" << endl;
+    cout << "shortestPathTree()  : " << heapMs << " ms/query (" << heapQueries << " queries)" << endl;
+    cout << "Speedup             : " << legacyMs / heapMs << "x" << endl;
+    cout << "Checksum            : " << checksum << endl;
+
+    // Point-to-point queries between random airport pairs
+    const unsigned pairQueries = 500;
+    long long treeSettled = 0, bidirectionalSettled = 0;
+    start = Clock::now();
+    for (unsigned i = 0; i < pairQueries; i++) {
+        auto tree = g.shortestPathTree(sources[i % sources.size()]);
+        for (int d : tree.dist) treeSettled += d != INT_MAX;
+    }
+    double treeMs = chrono::duration<double, milli>(Clock::now() - start).count() / pairQueries;
+
+    long long earlyExitSettled = 0;
+    start = Clock::now();
+    for (unsigned i = 0; i < pairQueries; i++)
+        earlyExitSettled += g.shortestPath(sources[i % sources.size()], sources[(i * 7 + 1) % sources.size()], PathAlgorithm::Dijkstra).settled;
+    double earlyExitMs = chrono::duration<double, milli>(Clock::now() - start).count() / pairQueries;
+
+    start = Clock::now();
+    for (unsigned i = 0; i < pairQueries; i++)
+        bidirectionalSettled += g.shortestPath(sources[i % sources.size()], sources[(i * 7 + 1) % sources.size()], PathAlgorithm::Bidirectional).settled;
+    double bidirectionalMs = chrono::duration<double, milli>(Clock::now() - start).count() / pairQueries;
+
+    // The first A* query builds the airport positions the heuristic reads
+    long long astarSettled = 0;
+    g.shortestPath(sources[0], sources[1], PathAlgorithm::AStar);
+    start = Clock::now();
+    for (unsigned i = 0; i < pairQueries; i++)
+        astarSettled += g.shortestPath(sources[i % sources.size()], sources[(i * 7 + 1) % sources.size()], PathAlgorithm::AStar).settled;
+    double astarMs = chrono::duration<double, milli>(Clock::now() - start).count() / pairQueries;
+
+    cout << "Point-to-point (" << pairQueries << " random pairs)" << endl;
+    cout << "  shortestPathTree() : " << treeMs << " ms/query, " << treeSettled / pairQueries << " settled/query" << endl;
+    cout << "  Dijkstra           : " << earlyExitMs << " ms/query, " << earlyExitSettled / pairQueries << " settled/query" << endl;
+    cout << "  Bidirectional      : " << bidirectionalMs << " ms/query, " << bidirectionalSettled / pairQueries << " settled/query" << endl;
+    cout << "  A*                 : " << astarMs << " ms/query, " << astarSettled / pairQueries << " settled/query" << endl;
+
+    // The same bidirectional queries with one workspace kept across them versus a new one per query
+    start = Clock::now();
+    for (unsigned i = 0; i < pairQueries; i++) {
+        SearchWorkspace fresh;
+        g.shortestPath(sources[i % sources.size()], sources[(i * 7 + 1) % sources.size()], PathAlgorithm::Bidirectional, fresh);
+    }
+    double freshMs = chrono::duration<double, milli>(Clock::now() - start).count() / pairQueries;
+
+    SearchWorkspace reused;
+    start = Clock::now();
+    for (unsigned i = 0; i < pairQueries; i++)
+        g.shortestPath(sources[i % sources.size()], sources[(i * 7 + 1) % sources.size()], PathAlgorithm::Bidirectional, reused);
+    double reusedMs = chrono::duration<double, milli>(Clock::now() - start).count() / pairQueries;
+
+    cout << "Bidirectional workspace" << endl;
+    cout << "  new per query      : " << freshMs << " ms/query" << endl;
+    cout << "  reused             : " << reusedMs << " ms/query" << endl;
+    return 0;
+}
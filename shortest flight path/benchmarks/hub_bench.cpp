@@ -0,0 +1,59 @@
+/**
+ * @file hub_bench.cpp
+ * Reports the size of the hub label index for the OpenFlights dataset, how long it takes to build,
+ * and the latency of distance and path queries against Dijkstra on random airport pairs.
+ */
+
+#include "../graph/graph.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+int main() {
+    Graph g("assets/airports.csv", "assets/routes.csv");
+    g.prepareContractionHierarchy();
+
+    auto start = Clock::now();
+    g.prepareHubLabels();
+    double buildMs = chrono::duration<double, milli>(Clock::now() - start).count();
+
+    const HubLabels& labels = g.getHubLabels();
+    cout << "Build           : " << buildMs << " ms (on top of the Contraction Hierarchy order)" << endl;
+    cout << "Index size      : " << labels.entryCount() << " entries, " << labels.bytes() / 1024.0 << " KiB, "
+         << (double) labels.entryCount() / (2 * labels.vertexCount()) << " hubs per label" << endl;
+
+    vector<Vertex> airports;
+    for (Vertex v = 0; v < 15000; v++)
+        if (g.vertexExists(v) && !g.getAirport(v).getName().empty() && !g.getOutgoing(v).empty()) airports.push_back(v);
+    mt19937 rng(225);
+    uniform_int_distribution<size_t> pick(0, airports.size() - 1);
+    vector<pair<Vertex, Vertex>> pairs;
+    for (int i = 0; i < 10000; i++) pairs.push_back({airports[pick(rng)], airports[pick(rng)]});
+
+    // Distance only
+    long long checksum = 0;
+    start = Clock::now();
+    for (auto& od : pairs) checksum += g.shortestDistance(od.first, od.second);
+    double distanceUs = chrono::duration<double, micro>(Clock::now() - start).count() / pairs.size();
+
+    // Full paths, checked against Dijkstra
+    const size_t pathPairs = 1000;
+    int mismatches = 0;
+    vector<int> expected;
+    start = Clock::now();
+    for (size_t i = 0; i < pathPairs; i++) expected.push_back(g.shortestPath(pairs[i].first, pairs[i].second, PathAlgorithm::Dijkstra).totalDistance);
+    double dijkstraUs = chrono::duration<double, micro>(Clock::now() - start).count() / pathPairs;
+    start = Clock::now();
+    for (size_t i = 0; i < pathPairs; i++) mismatches += g.shortestPath(pairs[i].first, pairs[i].second, PathAlgorithm::HubLabels).totalDistance != expected[i];
+    double pathUs = chrono::duration<double, micro>(Clock::now() - start).count() / pathPairs;
+
+    cout << "Distance query  : " << distanceUs << " us/query (" << pairs.size() << " pairs, checksum " << checksum << ")" << endl;
+    cout << "Path query      : " << pathUs << " us/query (" << pathPairs << " pairs" << (mismatches ? ", " + to_string(mismatches) + " MISMATCHES" : "") << ")" << endl;
+    cout << "Dijkstra path   : " << dijkstraUs << " us/query" << endl;
+    return 0;
+}
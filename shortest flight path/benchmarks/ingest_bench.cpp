@@ -0,0 +1,56 @@
+/**
+ * @file ingest_bench.cpp
+ * Measures how route CSV loading scales with the number of parser threads.
+ * The OpenFlights route table is repeated to build a large route file in the same schema.
+ */
+
+#include "../graph/graph.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+int main() {
+    const int copies = 16;
+    const char* path = "bench_ingest_routes.csv";
+
+    ifstream in("assets/routes.csv", ios::binary);
+    stringstream routes;
+    routes << in.rdbuf();
+    {
+        ofstream out(path, ios::binary);
+        for (int i = 0; i < copies; i++) out << routes.str();
+    }
+    cout << "Route file     : " << routes.str().size() * copies / (1024 * 1024) << " MiB (" << copies << " copies of assets/routes.csv)" << endl;
+
+    Graph airports;
+    airports.readAirportCSV("assets/airports.csv");
+
+    unsigned maxThreads = max(1u, thread::hardware_concurrency());
+    const int runs = 5;
+    int expectedEdges = -1;
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        double ms = 0;
+        int edges = 0;
+        for (int i = 0; i < runs; i++) {
+            Graph g = airports;
+            auto start = Clock::now();
+            g.loadRouteCSV(path, threads);
+            ms += chrono::duration<double, milli>(Clock::now() - start).count();
+            edges = g.getEdgeCount();
+        }
+        if (expectedEdges == -1) expectedEdges = edges;
+        cout << "threads " << threads << "      : " << ms / runs << " ms, " << edges << " edges" << (edges == expectedEdges ? "" : " (MISMATCH)") << endl;
+        if (threads == maxThreads) break;
+        if (threads * 2 > maxThreads) threads = maxThreads / 2;
+    }
+
+    remove(path);
+    return 0;
+}
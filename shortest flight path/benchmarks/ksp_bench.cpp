@@ -0,0 +1,57 @@
+/**
+ * @file ksp_bench.cpp
+ * Times kShortestPaths() for k = 5 and k = 20 on random connected airport pairs, reporting airports settled per query
+ * and checking that every first route matches Dijkstra and that lengths never decrease down the list.
+ */
+
+#include "../graph/graph.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+int main() {
+    Graph g("assets/airports.csv", "assets/routes.csv");
+
+    vector<Vertex> airports;
+    for (Vertex v = 0; v < 15000; v++)
+        if (g.vertexExists(v) && !g.getAirport(v).getName().empty() && !g.getOutgoing(v).empty()) airports.push_back(v);
+    mt19937 rng(225);
+    uniform_int_distribution<size_t> pick(0, airports.size() - 1);
+
+    vector<pair<Vertex, Vertex>> pairs;
+    vector<int> shortest;
+    while (pairs.size() < 200) {
+        Vertex s = airports[pick(rng)], t = airports[pick(rng)];
+        int distance = g.shortestPath(s, t, PathAlgorithm::Dijkstra).totalDistance;
+        if (s == t || distance == INT_MAX) continue;
+        pairs.push_back({s, t});
+        shortest.push_back(distance);
+    }
+
+    SearchWorkspace workspace;
+    for (int k : {5, 20}) {
+        long long settled = 0, routes = 0, spread = 0;
+        int mismatches = 0;
+        auto start = Clock::now();
+        for (size_t i = 0; i < pairs.size(); i++) {
+            auto results = g.kShortestPaths(pairs[i].first, pairs[i].second, k, workspace);
+            routes += results.size();
+            mismatches += results.empty() || results[0].totalDistance != shortest[i];
+            for (size_t j = 0; j < results.size(); j++) {
+                settled += results[j].settled;
+                if (j > 0) mismatches += results[j].totalDistance < results[j - 1].totalDistance;
+            }
+            if (!results.empty()) spread += results.back().totalDistance - results[0].totalDistance;
+        }
+        double ms = chrono::duration<double, milli>(Clock::now() - start).count() / pairs.size();
+        cout << "k = " << k << " : " << ms << " ms/query, " << settled / pairs.size() << " settled/query, "
+             << (double) routes / pairs.size() << " routes/query, last route " << spread / pairs.size() << " km longer than the first"
+             << (mismatches ? " (" + to_string(mismatches) + " MISMATCHES)" : "") << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file load_bench.cpp
+ * Measures how long it takes to build the full OpenFlights graph from the CSV files and from a binary snapshot.
+ */
+
+#include "../graph/graph.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+int main() {
+    const int runs = 20;
+    double airportsMs = 0, routesMs = 0, freezeMs = 0;
+
+    for (int i = 0; i < runs; i++) {
+        Graph g;
+        auto start = Clock::now();
+        g.readAirportCSV("assets/airports.csv");
+        auto airports = Clock::now();
+        g.loadRouteCSV("assets/routes.csv");
+        auto routes = Clock::now();
+        g.freeze();
+        auto frozen = Clock::now();
+
+        airportsMs += chrono::duration<double, milli>(airports - start).count();
+        routesMs += chrono::duration<double, milli>(routes - airports).count();
+        freezeMs += chrono::duration<double, milli>(frozen - routes).count();
+    }
+
+    cout << "readAirportCSV : " << airportsMs / runs << " ms" << endl;
+    cout << "loadRouteCSV   : " << routesMs / runs << " ms" << endl;
+    cout << "freeze         : " << freezeMs / runs << " ms" << endl;
+    cout << "Total          : " << (airportsMs + routesMs + freezeMs) / runs << " ms (average of " << runs << " loads)" << endl;
+
+    // Loading the same graph back from a binary snapshot
+    Graph("assets/airports.csv", "assets/routes.csv").writeSnapshot("bench_load.snapshot", "assets/airports.csv", "assets/routes.csv");
+    const int snapshotRuns = 200;
+    double snapshotMs = 0;
+    for (int i = 0; i < snapshotRuns; i++) {
+        Graph g;
+        auto start = Clock::now();
+        if (!g.readSnapshot("bench_load.snapshot", "assets/airports.csv", "assets/routes.csv")) {
+            cout << "Snapshot was rejected" << endl;
+            return 1;
+        }
+        snapshotMs += chrono::duration<double, milli>(Clock::now() - start).count();
+    }
+    remove("bench_load.snapshot");
+    cout << "readSnapshot   : " << snapshotMs / snapshotRuns << " ms (average of " << snapshotRuns << " loads)" << endl;
+    return 0;
+}
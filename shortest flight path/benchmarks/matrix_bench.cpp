@@ -0,0 +1,50 @@
+/**
+ * @file matrix_bench.cpp
+ * Times distanceMatrix() on 100x100 and 1000x1000 random airport sets against one full shortestPathTree() per source,
+ * and checks that both give the same distances.
+ */
+
+#include "../graph/graph.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+int main() {
+    Graph g("assets/airports.csv", "assets/routes.csv");
+    g.prepareContractionHierarchy();
+
+    vector<Vertex> airports;
+    for (Vertex v = 0; v < 15000; v++)
+        if (g.vertexExists(v) && !g.getAirport(v).getName().empty() && !g.getOutgoing(v).empty()) airports.push_back(v);
+
+    mt19937 rng(225);
+    for (size_t size : {100, 1000}) {
+        shuffle(airports.begin(), airports.end(), rng);
+        vector<Vertex> sources(airports.begin(), airports.begin() + size);
+        shuffle(airports.begin(), airports.end(), rng);
+        vector<Vertex> targets(airports.begin(), airports.begin() + size);
+
+        auto start = Clock::now();
+        vector<int> matrix = g.distanceMatrix(sources, targets);
+        double matrixMs = chrono::duration<double, milli>(Clock::now() - start).count();
+
+        // One full search per source
+        int mismatches = 0;
+        start = Clock::now();
+        for (size_t i = 0; i < size; i++) {
+            auto tree = g.shortestPathTree(sources[i]);
+            for (size_t j = 0; j < size; j++) mismatches += tree.dist[g.indexOf(targets[j])] != matrix[i * size + j];
+        }
+        double treeMs = chrono::duration<double, milli>(Clock::now() - start).count();
+
+        cout << size << "x" << size << " distanceMatrix()        : " << matrixMs << " ms" << endl;
+        cout << size << "x" << size << " shortestPathTree() rows : " << treeMs << " ms" << (mismatches ? " (" + to_string(mismatches) + " MISMATCHES)" : "") << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file pareto_bench.cpp
+ * Times paretoRoutes() on random intercontinental airport pairs and reports how many Pareto-optimal routes each pair
+ * has and how many labels the search creates, checking the shortest route of every front against Dijkstra.
+ */
+
+#include "../graph/graph.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+int main() {
+    Graph g("assets/airports.csv", "assets/routes.csv");
+
+    vector<Vertex> airports;
+    for (Vertex v = 0; v < 15000; v++)
+        if (g.vertexExists(v) && !g.getAirport(v).getName().empty() && !g.getOutgoing(v).empty()) airports.push_back(v);
+    mt19937 rng(225);
+    uniform_int_distribution<size_t> pick(0, airports.size() - 1);
+
+    // Pairs more than 8000 km apart that are connected at all
+    vector<pair<Vertex, Vertex>> pairs;
+    vector<int> shortest;
+    while (pairs.size() < 500) {
+        Vertex s = airports[pick(rng)], t = airports[pick(rng)];
+        if (g.getDistance(s, t) < 8000) continue;
+        int distance = g.shortestPath(s, t, PathAlgorithm::Dijkstra).totalDistance;
+        if (distance == INT_MAX) continue;
+        pairs.push_back({s, t});
+        shortest.push_back(distance);
+    }
+
+    auto start = Clock::now();
+    for (auto& od : pairs) g.shortestPath(od.first, od.second, PathAlgorithm::Dijkstra);
+    double dijkstraUs = chrono::duration<double, micro>(Clock::now() - start).count() / pairs.size();
+
+    ParetoSearch search;
+    long long routes = 0, labels = 0;
+    size_t largest = 0, mostLabels = 0;
+    int mismatches = 0;
+    start = Clock::now();
+    for (size_t i = 0; i < pairs.size(); i++) {
+        auto front = g.paretoRoutes(pairs[i].first, pairs[i].second, INT_MAX, search);
+        routes += front.size();
+        largest = max(largest, front.size());
+        labels += search.labelCount();
+        mostLabels = max(mostLabels, search.labelCount());
+        mismatches += front.empty() || front.back().distance != shortest[i];
+    }
+    double paretoUs = chrono::duration<double, micro>(Clock::now() - start).count() / pairs.size();
+
+    cout << pairs.size() << " intercontinental pairs" << endl;
+    cout << "Dijkstra       : " << dijkstraUs << " us/query" << endl;
+    cout << "paretoRoutes() : " << paretoUs << " us/query" << (mismatches ? " (" + to_string(mismatches) + " MISMATCHES)" : "") << endl;
+    cout << "Front size     : " << (double) routes / pairs.size() << " routes on average, " << largest << " at most" << endl;
+    cout << "Labels         : " << labels / pairs.size() << " per query, " << mostLabels << " at most" << endl;
+    return 0;
+}
@@ -0,0 +1,156 @@
+/**
+ * @file server_bench.cpp
+ * Load generator for the Unix socket query server. Starts a QueryServer in this process (or targets one already
+ * running, given its socket path), then has 1 to 16 clients each send random airport pairs one at a time and wait for
+ * every reply, reporting throughput and p50/p99 latency. Replies from the in-process server are checked against
+ * bidirectional Dijkstra, and a pipelined client shows the throughput when replies are not awaited one by one.
+ */
+
+#include "../graph/graph.h"
+#include "../graph/server.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+/**
+ * A blocking client connection that reads replies a line at a time
+ */
+class Client {
+    public:
+    explicit Client(const string& path) {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+        if (fd == -1 || connect(fd, (sockaddr*) &address, sizeof(address)) == -1) throw runtime_error("Cannot connect to " + path);
+    }
+    ~Client() { close(fd); }
+
+    void send(const string& data) {
+        for (size_t sent = 0; sent < data.size();) {
+            ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) throw runtime_error("Server closed the connection");
+            sent += n;
+        }
+    }
+
+    string line() {
+        size_t newline;
+        while ((newline = buffer.find('\n')) == string::npos) {
+            char chunk[65536];
+            ssize_t n = read(fd, chunk, sizeof(chunk));
+            if (n <= 0) throw runtime_error("Server closed the connection");
+            buffer.append(chunk, n);
+        }
+        string reply = buffer.substr(0, newline);
+        buffer.erase(0, newline + 1);
+        return reply;
+    }
+
+    private:
+    int fd;
+    string buffer;
+};
+
+/**
+ * @return the total distance of an "OK <km> ..." reply, or INT_MAX for any other reply
+ */
+int replyDistance(const string& reply) {
+    return reply.compare(0, 3, "OK ") == 0 ? stoi(reply.substr(3)) : INT_MAX;
+}
+
+int main(int argc, char* argv[]) {
+    Graph g("assets/airports.csv", "assets/routes.csv");
+    vector<Vertex> airports;
+    for (Vertex v = 0; v < 15000; v++)
+        if (g.vertexExists(v) && !g.getAirport(v).getName().empty() && !g.getOutgoing(v).empty()) airports.push_back(v);
+
+    mt19937 rng(225);
+    uniform_int_distribution<size_t> pick(0, airports.size() - 1);
+    vector<pair<Vertex, Vertex>> queries;
+    for (int i = 0; i < 4000; i++) queries.push_back({airports[pick(rng)], airports[pick(rng)]});
+
+    // Serve from this process unless pointed at a running server
+    bool local = argc < 2;
+    string path = local ? "bench_server.sock" : argv[1];
+    ThreadPool pool;
+    QueryServer server(g, pool);
+    thread loop;
+    vector<int> expected;
+    if (local) {
+        server.listen(path);
+        loop = thread([&]() { server.run(); });
+        for (auto& od : queries) expected.push_back(g.shortestPath(od.first, od.second).totalDistance);
+        cout << "In-process server on " << path << " with " << pool.size() << " threads" << endl;
+    } else {
+        cout << "Server on " << path << endl;
+    }
+
+    int mismatches = 0;
+    for (int clients : {1, 4, 16}) {
+        vector<vector<double>> latencies(clients);
+        vector<int> wrong(clients, 0);
+        auto start = Clock::now();
+        vector<thread> threads;
+        for (int c = 0; c < clients; c++) {
+            threads.emplace_back([&, c]() {
+                Client client(path);
+                for (size_t i = c; i < queries.size(); i += clients) {
+                    auto sent = Clock::now();
+                    client.send(to_string(queries[i].first) + " " + to_string(queries[i].second) + "\n");
+                    string reply = client.line();
+                    latencies[c].push_back(chrono::duration<double, micro>(Clock::now() - sent).count());
+                    if (local) wrong[c] += replyDistance(reply) != expected[i];
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+        double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+        vector<double> all;
+        for (int c = 0; c < clients; c++) {
+            all.insert(all.end(), latencies[c].begin(), latencies[c].end());
+            mismatches += wrong[c];
+        }
+        sort(all.begin(), all.end());
+        cout << clients << " clients" << string(clients < 10 ? 2 : 1, ' ') << ": " << (int) (all.size() / seconds) << " queries/s, p50 "
+             << all[all.size() / 2] << " us, p99 " << all[all.size() * 99 / 100] << " us, max " << all.back() << " us" << endl;
+    }
+
+    // One client writes every query up front, then reads the replies
+    {
+        Client client(path);
+        string requests;
+        for (auto& od : queries) requests += to_string(od.first) + " " + to_string(od.second) + "\n";
+        auto start = Clock::now();
+        thread writer([&]() { client.send(requests); });
+        for (size_t i = 0; i < queries.size(); i++) {
+            string reply = client.line();
+            if (local) mismatches += replyDistance(reply) != expected[i];
+        }
+        writer.join();
+        double seconds = chrono::duration<double>(Clock::now() - start).count();
+        cout << "Pipelined  : " << (int) (queries.size() / seconds) << " queries/s" << endl;
+    }
+
+    if (local) {
+        server.stop();
+        loop.join();
+        cout << "Answered " << server.answered() << " queries" << (mismatches ? " (" + to_string(mismatches) + " MISMATCHES)" : "") << endl;
+    }
+    return 0;
+}
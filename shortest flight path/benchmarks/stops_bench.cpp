@@ -0,0 +1,55 @@
+/**
+ * @file stops_bench.cpp
+ * Times hop-limited queries with 0 to 4 stops on random airport pairs, and reports how many pairs each limit can
+ * still connect and how much longer their routes get than the unconstrained shortest route.
+ */
+
+#include "../graph/graph.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+int main() {
+    Graph g("assets/airports.csv", "assets/routes.csv");
+
+    vector<Vertex> airports;
+    for (Vertex v = 0; v < 15000; v++)
+        if (g.vertexExists(v) && !g.getAirport(v).getName().empty() && !g.getOutgoing(v).empty()) airports.push_back(v);
+    mt19937 rng(225);
+    uniform_int_distribution<size_t> pick(0, airports.size() - 1);
+    vector<pair<Vertex, Vertex>> queries;
+    while (queries.size() < 2000) {
+        Vertex s = airports[pick(rng)], t = airports[pick(rng)];
+        if (s != t) queries.push_back({s, t});
+    }
+
+    vector<int> shortest;
+    auto start = Clock::now();
+    for (auto& od : queries) shortest.push_back(g.shortestPath(od.first, od.second, PathAlgorithm::Dijkstra).totalDistance);
+    double dijkstraUs = chrono::duration<double, micro>(Clock::now() - start).count() / queries.size();
+    cout << "Dijkstra, no limit : " << dijkstraUs << " us/query" << endl;
+
+    SearchWorkspace workspace;
+    for (int stops = 0; stops <= 4; stops++) {
+        int found = 0;
+        long long settled = 0;
+        double detour = 0;
+        start = Clock::now();
+        for (size_t i = 0; i < queries.size(); i++) {
+            auto result = g.shortestPathWithStops(queries[i].first, queries[i].second, stops, workspace);
+            settled += result.settled;
+            if (!result.found()) continue;
+            found++;
+            detour += (double) result.totalDistance / max(1, shortest[i]);
+        }
+        double us = chrono::duration<double, micro>(Clock::now() - start).count() / queries.size();
+        cout << "at most " << stops << " stops    : " << us << " us/query, " << (double) settled / queries.size() << " expanded/query, "
+             << 100.0 * found / queries.size() << "% connected, " << (found ? 100.0 * (detour / found - 1) : 0) << "% longer on average" << endl;
+    }
+    return 0;
+}
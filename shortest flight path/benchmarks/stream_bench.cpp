@@ -0,0 +1,89 @@
+/**
+ * @file stream_bench.cpp
+ * Streams a file of random airport pairs, named by OpenFlights number and IATA code, through runBatch as the
+ * "--batch" mode of final_proj does, reporting queries per second and how much the peak resident memory grew for each
+ * output format and ordering.
+ */
+
+#include "../graph/batch.h"
+#include "../graph/graph.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <sys/resource.h>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+/**
+ * @return the peak resident memory of the process so far, in KiB
+ */
+long peakKiB() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/**
+ * Output stream that drops everything, so the timings only cover reading, answering and formatting
+ */
+class NullBuffer : public streambuf {
+    protected:
+    int overflow(int c) override { return c; }
+    streamsize xsputn(const char*, streamsize n) override { return n; }
+};
+
+int main() {
+    Graph g("assets/airports.csv", "assets/routes.csv");
+    vector<string> names;
+    for (Vertex v = 0; v < 15000; v++) {
+        if (!g.vertexExists(v) || g.getAirport(v).getName().empty() || g.getOutgoing(v).empty()) continue;
+        names.push_back(to_string(v));
+        string iata = g.getAirport(v).getIATA();
+        if (iata.size() == 3 && g.findAirport(iata) == v) names.push_back(iata);
+    }
+
+    const int queries = 10000;
+    const char* path = "bench_stream_pairs.txt";
+    {
+        mt19937 rng(225);
+        uniform_int_distribution<size_t> pick(0, names.size() - 1);
+        ofstream out(path);
+        for (int i = 0; i < queries; i++) out << names[pick(rng)] << (i % 2 ? "," : " ") << names[pick(rng)] << "\n";
+    }
+
+    ThreadPool pool;
+    g.prepare(PathAlgorithm::Bidirectional);
+    long baseline = peakKiB();
+    cout << queries << " pairs on " << pool.size() << " threads" << endl;
+
+    struct Run {
+        const char* name;
+        BatchOptions::Format format;
+        bool ordered;
+    };
+    for (Run run : {Run{"CSV, ordered   ", BatchOptions::Format::CSV, true}, Run{"CSV, unordered ", BatchOptions::Format::CSV, false},
+                    Run{"JSONL, ordered ", BatchOptions::Format::JSONL, true}}) {
+        BatchOptions options;
+        options.format = run.format;
+        options.ordered = run.ordered;
+        ifstream in(path);
+        NullBuffer discard;
+        ostream out(&discard);
+
+        auto start = Clock::now();
+        BatchStats stats = runBatch(g, in, out, pool, options);
+        double seconds = chrono::duration<double>(Clock::now() - start).count();
+        cout << run.name << ": " << (int) (stats.queries / seconds) << " queries/s, " << stats.found << " routes, "
+             << stats.errors << " errors, peak memory +" << peakKiB() - baseline << " KiB"
+             << (stats.queries == (size_t) queries ? "" : " (MISMATCH)") << endl;
+    }
+
+    remove(path);
+    return 0;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file update_bench.cpp
+ * Cancels and restores routes used by cached shortest path trees, timing the update plus a burst of cached queries
+ * against rebuilding the edge arrays and trees from scratch, and checks every answer against Dijkstra.
+ */
+
+#include "../graph/graph.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+int main() {
+    auto loadStart = Clock::now();
+    Graph g("assets/airports.csv", "assets/routes.csv");
+    double loadMs = chrono::duration<double, milli>(Clock::now() - loadStart).count();
+
+    vector<Vertex> airports;
+    for (Vertex v = 0; v < 15000; v++)
+        if (g.vertexExists(v) && !g.getAirport(v).getName().empty() && !g.getOutgoing(v).empty()) airports.push_back(v);
+    vector<Vertex> hubs = airports;
+    sort(hubs.begin(), hubs.end(), [&](Vertex a, Vertex b) { return g.getOutgoing(a).size() > g.getOutgoing(b).size(); });
+    hubs.resize(100);
+
+    mt19937 rng(225);
+    uniform_int_distribution<size_t> hub(0, hubs.size() - 1), destination(0, airports.size() - 1);
+    vector<pair<Vertex, Vertex>> queries;
+    for (int i = 0; i < 200; i++) queries.push_back({hubs[hub(rng)], airports[destination(rng)]});
+
+    auto warm = [&]() {
+        for (Vertex h : hubs) g.shortestPath(h, h == airports[0] ? airports[1] : airports[0], PathAlgorithm::CachedTree);
+    };
+    int mismatches = 0;
+    auto requery = [&](vector<int>& answers) {
+        answers.clear();
+        for (auto& od : queries) answers.push_back(g.shortestPath(od.first, od.second, PathAlgorithm::CachedTree).totalDistance);
+    };
+    auto check = [&](const vector<int>& answers) {
+        for (size_t i = 0; i < queries.size(); i++)
+            mismatches += g.shortestPath(queries[i].first, queries[i].second, PathAlgorithm::Dijkstra).totalDistance != answers[i];
+    };
+
+    const int rounds = 50;
+    double removeMs = 0, restoreMs = 0, rebuildMs = 0, requeryMs = 0, coldMs = 0;
+    vector<int> answers;
+    warm();
+    for (int round = 0; round < rounds; round++) {
+        // Cancel a route some cached tree uses, so the update has a subtree to repair
+        int h = g.indexOf(hubs[hub(rng)]);
+        shared_ptr<const ShortestPathTree> tree = g.getTreeCache().find(h);
+        int v;
+        do v = g.indexOf(airports[destination(rng)]); while (v == h || !tree->reached(v));
+        int u = tree->parent[v];
+        int weight = g.getCSR().weight(u, v);
+
+        auto start = Clock::now();
+        g.removeRoute(g.codeOf(u), g.codeOf(v));
+        auto updated = Clock::now();
+        requery(answers);
+        auto done = Clock::now();
+        removeMs += chrono::duration<double, milli>(updated - start).count();
+        requeryMs += chrono::duration<double, milli>(done - updated).count();
+        check(answers);
+
+        // The same state again the old way: rebuild the edge arrays, drop every tree and build them on demand
+        start = Clock::now();
+        g.freeze();
+        updated = Clock::now();
+        requery(answers);
+        done = Clock::now();
+        rebuildMs += chrono::duration<double, milli>(updated - start).count();
+        coldMs += chrono::duration<double, milli>(done - updated).count();
+        check(answers);
+
+        warm();
+        start = Clock::now();
+        g.addRoute(g.codeOf(u), g.codeOf(v), weight);
+        restoreMs += chrono::duration<double, milli>(Clock::now() - start).count();
+        requery(answers);
+        check(answers);
+    }
+
+    cout << rounds << " cancellations of routes used by " << hubs.size() << " cached trees, " << queries.size() << " cached queries after each" << endl;
+    cout << "Reload from CSV      : " << loadMs << " ms" << endl;
+    cout << "Cancel route + repair: " << removeMs / rounds << " ms, requery " << requeryMs / rounds << " ms" << endl;
+    cout << "Restore route        : " << restoreMs / rounds << " ms" << endl;
+    cout << "Rebuild arrays       : " << rebuildMs / rounds << " ms, requery " << coldMs / rounds << " ms (trees rebuilt)"
+         << (mismatches ? " (" + to_string(mismatches) + " MISMATCHES)" : "") << endl;
+    return 0;
+}
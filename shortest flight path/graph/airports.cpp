@@ -0,0 +1,52 @@
+#include "airports.h"
+#include "snapshot.h"
+
+#include <stdexcept>
+
+int AirportTable::add(Vertex code) {
+    codes.edit().push_back(code);
+    latitudes.edit().push_back(0);
+    longitudes.edit().push_back(0);
+    spans.edit().resize(spans.size() + TEXT_FIELDS * 2, 0);
+    return size() - 1;
+}
+
+void AirportTable::set(int index, Vertex code, string_view name, string_view city, string_view country, string_view IATA, string_view ICAO, double latitude, double longitude) {
+    codes.edit()[index] = code;
+    latitudes.edit()[index] = latitude;
+    longitudes.edit()[index] = longitude;
+
+    // Append the text to the pool and point the airport's spans at it
+    auto& chars = pool.edit();
+    auto& span = spans.edit();
+    string_view fields[TEXT_FIELDS] = {name, city, country, IATA, ICAO};
+    for (int f = 0; f < TEXT_FIELDS; f++) {
+        span[(index * TEXT_FIELDS + f) * 2] = (uint32_t) chars.size();
+        span[(index * TEXT_FIELDS + f) * 2 + 1] = (uint32_t) fields[f].size();
+        chars.insert(chars.end(), fields[f].begin(), fields[f].end());
+    }
+}
+
+Airport AirportTable::get(int index) const {
+    return Airport(string(name(index)), string(city(index)), string(country(index)), string(IATA(index)), string(ICAO(index)), latitude(index), longitude(index), code(index));
+}
+
+void AirportTable::save(SnapshotWriter& writer) const {
+    writer.column(codes);
+    writer.column(latitudes);
+    writer.column(longitudes);
+    writer.column(spans);
+    writer.column(pool);
+}
+
+void AirportTable::load(SnapshotReader& reader) {
+    codes = reader.column<Vertex>();
+    latitudes = reader.column<double>();
+    longitudes = reader.column<double>();
+    spans = reader.column<uint32_t>();
+    pool = reader.column<char>();
+    if (latitudes.size() != codes.size() || longitudes.size() != codes.size() || spans.size() != codes.size() * TEXT_FIELDS * 2)
+        throw std::runtime_error("Snapshot airport table is inconsistent");
+    for (size_t i = 0; i < spans.size(); i += 2)
+        if ((uint64_t) spans[i] + spans[i + 1] > pool.size()) throw std::runtime_error("Snapshot airport table is inconsistent");
+}
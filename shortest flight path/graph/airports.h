@@ -0,0 +1,77 @@
+/**
+ * @file airports.h
+ */
+
+#pragma once
+
+#include "column.h"
+#include "edge.h"
+
+#include <cstdint>
+#include <string_view>
+
+using std::string_view;
+
+class SnapshotWriter;
+class SnapshotReader;
+
+/**
+ * Stores every airport of a graph column by column, indexed by dense airport index.
+ * Codes and coordinates are flat arrays and all text lives in one shared character pool,
+ * so the table can be saved to and loaded from a snapshot without touching each airport.
+ */
+class AirportTable {
+    public:
+
+    /**
+     * @return the number of airports in the table
+     */
+    int size() const { return (int) codes.size(); }
+
+    /**
+     * Appends a placeholder airport that only has a code and sits at latitude and longitude 0
+     * @param code OpenFlights airport code
+     * @return the index of the new airport
+     */
+    int add(Vertex code);
+
+    /**
+     * Replaces every field of an airport
+     * @param index Index of the airport to replace
+     */
+    void set(int index, Vertex code, string_view name, string_view city, string_view country, string_view IATA, string_view ICAO, double latitude, double longitude);
+
+    Vertex code(int index) const { return codes[index]; }
+    double latitude(int index) const { return latitudes[index]; }
+    double longitude(int index) const { return longitudes[index]; }
+    string_view name(int index) const { return text(index, 0); }
+    string_view city(int index) const { return text(index, 1); }
+    string_view country(int index) const { return text(index, 2); }
+    string_view IATA(int index) const { return text(index, 3); }
+    string_view ICAO(int index) const { return text(index, 4); }
+
+    /**
+     * @param index Index of the airport
+     * @return a standalone Airport object holding a copy of the airport's fields
+     */
+    Airport get(int index) const;
+
+    void save(SnapshotWriter& writer) const;
+    void load(SnapshotReader& reader);
+
+    private:
+    static const int TEXT_FIELDS = 5;
+
+    Column<Vertex> codes;
+    Column<double> latitudes;
+    Column<double> longitudes;
+
+    // For each airport, an (offset, length) pair into pool for each of its text fields
+    Column<uint32_t> spans;
+    Column<char> pool;
+
+    string_view text(int index, int field) const {
+        const uint32_t* span = spans.data() + (index * TEXT_FIELDS + field) * 2;
+        return string_view(pool.data() + span[0], span[1]);
+    }
+};
@@ -0,0 +1,170 @@
+#include "batch.h"
+
+#include <cctype>
+#include <cstdio>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace {
+
+// Queries a worker answers before writing them in unordered mode
+const size_t GRAIN = 16;
+
+/**
+ * One input line and the record written for it
+ */
+struct Query {
+    size_t line;
+    string text;
+    string record;
+};
+
+/**
+ * @return field quoted for CSV if it contains a comma, quote or line break
+ */
+string csvField(const string& field) {
+    if (field.find_first_of(",\"\r\n") == string::npos) return field;
+    string quoted = "\"";
+    for (char c : field) quoted += c == '"' ? string("\"\"") : string(1, c);
+    return quoted + "\"";
+}
+
+/**
+ * @return field as a JSON string literal
+ */
+string jsonString(const string& field) {
+    string quoted = "\"";
+    for (char c : field) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if ((unsigned char) c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            quoted += escaped;
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+/**
+ * Answers one query line and formats its record, with a trailing newline
+ */
+string answer(const Graph& graph, const Query& query, const BatchOptions& options, SearchWorkspace& workspace, BatchStats& stats) {
+    // Split on whitespace and commas into exactly two airport names
+    vector<string> names;
+    size_t i = 0;
+    const string& text = query.text;
+    auto separator = [](char c) { return c == ',' || isspace((unsigned char) c); };
+    while (i < text.size()) {
+        while (i < text.size() && separator(text[i])) i++;
+        size_t start = i;
+        while (i < text.size() && !separator(text[i])) i++;
+        if (i > start) names.push_back(text.substr(start, i - start));
+    }
+
+    string error;
+    ShortestPathResult route;
+    if (names.size() != 2) {
+        error = "expected <from> <to>";
+    } else {
+        Vertex source = graph.findAirport(names[0]), destination = graph.findAirport(names[1]);
+        if (source == -1) error = "unknown airport " + names[0];
+        else if (destination == -1) error = "unknown airport " + names[1];
+        else route = graph.shortestPath(source, destination, options.algorithm, workspace);
+    }
+    string status = !error.empty() ? "error" : route.found() ? "ok" : "none";
+    (!error.empty() ? stats.errors : route.found() ? stats.found : stats.unreachable)++;
+    string from = names.size() > 0 ? names[0] : "", to = names.size() > 1 ? names[1] : "";
+
+    string record;
+    if (options.format == BatchOptions::Format::CSV) {
+        record = std::to_string(query.line) + "," + csvField(from) + "," + csvField(to) + "," + status + ",";
+        if (route.found()) record += std::to_string(route.totalDistance);
+        record += ",";
+        if (!error.empty()) record += csvField(error);
+        for (size_t leg = 0; leg < route.path.size(); leg++) record += (leg ? " " : "") + std::to_string(route.path[leg]);
+    } else {
+        record = "{\"line\":" + std::to_string(query.line) + ",\"from\":" + jsonString(from) + ",\"to\":" + jsonString(to) + ",\"status\":\"" + status + "\"";
+        if (!error.empty()) {
+            record += ",\"error\":" + jsonString(error);
+        } else if (route.found()) {
+            record += ",\"distance_km\":" + std::to_string(route.totalDistance) + ",\"path\":[";
+            for (size_t leg = 0; leg < route.path.size(); leg++) record += (leg ? "," : "") + std::to_string(route.path[leg]);
+            record += "]";
+        }
+        record += "}";
+    }
+    return record + "\n";
+}
+
+/**
+ * Reads up to count non-blank lines
+ * @param in Stream of query lines
+ * @param count Most lines to read
+ * @param line Number of the last line read, advanced past every line read including blank ones
+ * @param chunk Filled with the lines read
+ */
+void readChunk(std::istream& in, size_t count, size_t& line, vector<Query>& chunk) {
+    chunk.clear();
+    string text;
+    while (chunk.size() < count && std::getline(in, text)) {
+        line++;
+        if (!text.empty() && text.back() == '\r') text.pop_back();
+        if (text.find_first_not_of(" \t") == string::npos) continue;
+        chunk.push_back(Query{line, std::move(text), string()});
+    }
+}
+
+}
+
+BatchStats runBatch(Graph& graph, std::istream& in, std::ostream& out, ThreadPool& pool, const BatchOptions& options) {
+    graph.prepare(options.algorithm);
+    const Graph& frozen = graph;
+    size_t chunkSize = options.chunk == 0 ? 1 : options.chunk;
+
+    vector<SearchWorkspace> workspaces(pool.size());
+    vector<BatchStats> counts(pool.size());
+    std::mutex writing;
+    if (options.format == BatchOptions::Format::CSV) out << "line,from,to,status,distance_km,path\n";
+
+    // Answers and writes one chunk; in unordered mode each range goes out as soon as it is done
+    auto answerChunk = [&](vector<Query>& chunk) {
+        pool.parallelFor(chunk.size(), [&](size_t begin, size_t end, unsigned worker) {
+            for (size_t i = begin; i < end; i++) chunk[i].record = answer(frozen, chunk[i], options, workspaces[worker], counts[worker]);
+            if (options.ordered) return;
+            std::lock_guard<std::mutex> guard(writing);
+            for (size_t i = begin; i < end; i++) out << chunk[i].record;
+        }, GRAIN);
+        if (options.ordered)
+            for (auto& query : chunk) out << query.record;
+    };
+
+    // Read the next chunk while the pool answers the current one, then wait before reading any further
+    size_t line = 0;
+    vector<Query> current, next;
+    readChunk(in, chunkSize, line, current);
+    while (!current.empty()) {
+        std::future<void> answered = std::async(std::launch::async, answerChunk, std::ref(current));
+        readChunk(in, chunkSize, line, next);
+        answered.get();
+        std::swap(current, next);
+    }
+    out.flush();
+
+    BatchStats total;
+    for (auto& count : counts) {
+        total.found += count.found;
+        total.unreachable += count.unreachable;
+        total.errors += count.errors;
+    }
+    total.queries = total.found + total.unreachable + total.errors;
+    return total;
+}
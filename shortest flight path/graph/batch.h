@@ -0,0 +1,56 @@
+/**
+ * @file batch.h
+ */
+
+#pragma once
+
+#include "graph.h"
+#include "threadpool.h"
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+
+/**
+ * How runBatch reads, answers and writes a stream of queries
+ */
+struct BatchOptions {
+    enum class Format { CSV, JSONL };
+
+    Format format = Format::CSV;
+    // Write results in input order; otherwise each is written as soon as the range of queries holding it is done
+    bool ordered = true;
+    // Queries read and answered at a time; at most two chunks are held in memory
+    size_t chunk = 4096;
+    PathAlgorithm algorithm = PathAlgorithm::Bidirectional;
+};
+
+/**
+ * What happened to the queries of one runBatch call
+ */
+struct BatchStats {
+    size_t queries = 0;
+    size_t found = 0;
+    size_t unreachable = 0;
+    size_t errors = 0;
+};
+
+/**
+ * Answers a stream of origin/destination pairs, one per line as "<from> <to>" or "<from>,<to>", where each airport is an
+ * OpenFlights number or an IATA or ICAO code. Blank lines are skipped.
+ *
+ * Lines are read a chunk at a time. While the pool answers one chunk the calling thread reads the next, and it does
+ * not read further until that chunk has been written, so memory stays bounded by two chunks however long the input.
+ * The output has one record per query:
+ *     CSV   "line,from,to,status,distance_km,path" after a header row, e.g. "1,KZN,ORD,ok,8762,2990 2948 737 3830"
+ *     JSONL {"line":1,"from":"KZN","to":"ORD","status":"ok","distance_km":8762,"path":[2990,2948,737,3830]}
+ * where line is the 1-based input line, status is ok, none (no route) or error, and an error record carries its reason
+ * in place of the path.
+ * @param graph Graph to answer from; it is prepared for the algorithm first
+ * @param in Stream of query lines
+ * @param out Stream to write the results to; it is only written from one thread at a time
+ * @param pool Threads to answer each chunk on
+ * @param options Output format, ordering, chunk size and search engine
+ * @return counts of the queries answered
+ */
+BatchStats runBatch(Graph& graph, std::istream& in, std::ostream& out, ThreadPool& pool, const BatchOptions& options = BatchOptions());
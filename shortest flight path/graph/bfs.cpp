@@ -0,0 +1,170 @@
+#include "bfs.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+using std::atomic;
+using std::max;
+
+namespace {
+
+// Go bottom-up once the frontier has more than 1 / ALPHA of the arcs left to check, and back top-down once
+// the frontier holds fewer than 1 / BETA of the vertices
+const long long ALPHA = 14;
+const long long BETA = 24;
+
+// Smallest top-down range and bottom-up word range handed to one worker
+const size_t VERTEX_GRAIN = 256;
+const size_t WORD_GRAIN = 8;
+
+/**
+ * A bitset over vertices whose bits can be set from several threads at once
+ */
+class AtomicBitset {
+    public:
+    AtomicBitset(int bits) : count((bits + 63) / 64), words(new atomic<uint64_t>[count]) {
+        for (size_t w = 0; w < count; w++) words[w].store(0, std::memory_order_relaxed);
+    }
+
+    bool test(int v) const { return words[v >> 6].load(std::memory_order_relaxed) >> (v & 63) & 1; }
+
+    /**
+     * Sets bit v
+     * @return true if this call set it, false if it was already set
+     */
+    bool claim(int v) {
+        uint64_t bit = uint64_t(1) << (v & 63);
+        if (words[v >> 6].load(std::memory_order_relaxed) & bit) return false;
+        return !(words[v >> 6].fetch_or(bit, std::memory_order_relaxed) & bit);
+    }
+
+    uint64_t word(size_t w) const { return words[w].load(std::memory_order_relaxed); }
+    void setWord(size_t w, uint64_t value) { words[w].store(value, std::memory_order_relaxed); }
+    size_t wordCount() const { return count; }
+
+    private:
+    size_t count;
+    std::unique_ptr<atomic<uint64_t>[]> words;
+};
+
+/**
+ * Runs body(begin, end, worker) over [0, count) on the pool, or in one piece on the calling thread without one
+ */
+template <typename Body>
+void forRanges(ThreadPool* pool, size_t count, size_t grain, Body body) {
+    if (pool == nullptr || pool->size() <= 1 || count <= grain) {
+        body(0, count, 0u);
+        return;
+    }
+    pool->parallelFor(count, body, max(grain, count / (4 * pool->size())));
+}
+
+}
+
+HopTree breadthFirstTree(const CSRGraph& graph, int source, ThreadPool* pool, const ExclusionMask& avoid) {
+    int n = graph.vertexCount();
+    HopTree tree;
+    tree.source = source;
+    tree.hops.assign(n, INT_MAX);
+    tree.parent.assign(n, -1);
+    if (source < 0 || source >= n || avoid.excluded(source)) return tree;
+
+    unsigned workers = pool == nullptr ? 1 : max(1u, pool->size());
+    AtomicBitset visited(n), frontierBits(n), nextBits(n);
+    vector<int> frontier{source};
+    vector<vector<int>> nextParts(workers);
+    visited.claim(source);
+    tree.hops[source] = 0;
+
+    // Arcs leaving the frontier and arcs entering vertices not yet visited, which pick the direction of each level
+    long long frontierArcs = graph.outgoing(source).size();
+    long long unvisitedArcs = graph.edgeCount() - (long long) graph.incoming(source).size();
+
+    // Excluded vertices look visited from the start, and their arcs are never left to check
+    if (!avoid.empty()) {
+        for (int v = 0; v < n; v++) {
+            if (!avoid.excluded(v)) continue;
+            visited.claim(v);
+            unvisitedArcs -= graph.incoming(v).size();
+        }
+    }
+    bool bottomUp = false;
+    int level = 0;
+
+    while (!frontier.empty()) {
+        if (!bottomUp && frontierArcs * ALPHA > unvisitedArcs) {
+            bottomUp = true;
+            for (size_t w = 0; w < frontierBits.wordCount(); w++) frontierBits.setWord(w, 0);
+            for (int v : frontier) frontierBits.claim(v);
+        } else if (bottomUp && (long long) frontier.size() * BETA < n) {
+            bottomUp = false;
+        }
+
+        if (bottomUp) {
+            // Every unvisited vertex looks for a parent in the frontier; workers own whole words of the bitsets
+            forRanges(pool, visited.wordCount(), WORD_GRAIN, [&](size_t begin, size_t end, unsigned) {
+                for (size_t w = begin; w < end; w++) {
+                    uint64_t seen = visited.word(w), found = 0;
+                    for (int bit = 0; bit < 64; bit++) {
+                        int v = (int) (w * 64) + bit;
+                        if (v >= n) break;
+                        if (seen >> bit & 1) continue;
+                        for (auto arc : graph.incoming(v)) {
+                            if (frontierBits.test(arc.vertex)) {
+                                tree.parent[v] = arc.vertex;
+                                tree.hops[v] = level + 1;
+                                found |= uint64_t(1) << bit;
+                                break;
+                            }
+                        }
+                    }
+                    nextBits.setWord(w, found);
+                    visited.setWord(w, seen | found);
+                }
+            });
+            std::swap(frontierBits, nextBits);
+
+            // Rebuild the frontier list from its bitset, which also counts the arcs for the next decision
+            frontier.clear();
+            frontierArcs = 0;
+            for (size_t w = 0; w < frontierBits.wordCount(); w++) {
+                for (uint64_t bits = frontierBits.word(w); bits; bits &= bits - 1) {
+                    int v = (int) (w * 64) + __builtin_ctzll(bits);
+                    frontier.push_back(v);
+                    frontierArcs += graph.outgoing(v).size();
+                    unvisitedArcs -= graph.incoming(v).size();
+                }
+            }
+        } else {
+            // Every frontier vertex claims its unvisited neighbors; each worker collects the ones it claimed
+            forRanges(pool, frontier.size(), VERTEX_GRAIN, [&](size_t begin, size_t end, unsigned worker) {
+                vector<int>& next = nextParts[worker];
+                for (size_t i = begin; i < end; i++) {
+                    int u = frontier[i];
+                    for (auto arc : graph.outgoing(u)) {
+                        if (visited.claim(arc.vertex)) {
+                            tree.parent[arc.vertex] = u;
+                            tree.hops[arc.vertex] = level + 1;
+                            next.push_back(arc.vertex);
+                        }
+                    }
+                }
+            });
+
+            frontier.clear();
+            frontierArcs = 0;
+            for (auto& part : nextParts) {
+                for (int v : part) {
+                    frontier.push_back(v);
+                    frontierArcs += graph.outgoing(v).size();
+                    unvisitedArcs -= graph.incoming(v).size();
+                }
+                part.clear();
+            }
+        }
+        level++;
+    }
+    return tree;
+}
@@ -0,0 +1,48 @@
+/**
+ * @file bfs.h
+ */
+
+#pragma once
+
+#include "csr.h"
+#include "mask.h"
+#include "threadpool.h"
+
+#include <climits>
+#include <vector>
+
+using std::vector;
+
+/**
+ * Result of a breadth-first search, indexed by dense airport index.
+ * hops holds the fewest routes needed to get from the source (INT_MAX if unreachable) and parent holds an airport
+ * one hop closer to the source on such a route (-1 for the source and unreachable airports).
+ */
+struct HopTree {
+    int source = -1;
+    vector<int> hops;
+    vector<int> parent;
+
+    /**
+     * @param v Dense airport index
+     * @return true if v was reached from the source
+     */
+    bool reached(int v) const { return v >= 0 && v < (int) hops.size() && hops[v] != INT_MAX; }
+};
+
+/**
+ * Direction-optimizing breadth-first search (Beamer et al.). Levels start top-down, where every frontier vertex scans
+ * its outgoing arcs for unvisited vertices. Once the frontier's arcs outnumber the arcs into unvisited vertices by
+ * ALPHA, it switches bottom-up, where every unvisited vertex scans its incoming arcs for one in the frontier and stops
+ * at the first, and it switches back once the frontier shrinks below 1 / BETA of the vertices. On this small-world
+ * route graph the two or three levels around the hubs are the ones that go bottom-up.
+ * Visited and frontier sets are bitsets. With a pool, every level is split across its workers; top-down claims
+ * vertices with an atomic bit-or, and bottom-up gives each worker whole 64-vertex words so none is shared.
+ * Excluded vertices start out marked visited, so neither direction ever claims them or reaches past them.
+ * @param graph Graph to search
+ * @param source Dense index of the source
+ * @param pool Workers to expand each level on, or nullptr to run on the calling thread
+ * @param avoid Vertices the search must not pass through; nothing is reached if the source is one of them
+ * @return the hop distance and parent of every vertex
+ */
+HopTree breadthFirstTree(const CSRGraph& graph, int source, ThreadPool* pool = nullptr, const ExclusionMask& avoid = ExclusionMask());
@@ -0,0 +1,446 @@
+#include "ch.h"
+#include "heap.h"
+#include "snapshot.h"
+
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+
+using std::max;
+using std::min;
+
+namespace {
+
+/**
+ * An arc of the graph that is still being contracted
+ */
+struct DynamicArc {
+    int vertex;
+    int weight;
+    int middle;
+};
+
+// Settle limits of the witness searches used to estimate priorities and to actually contract
+const int SIMULATE_LIMIT = 50;
+const int CONTRACT_LIMIT = 500;
+
+// Priorities of vertices with more neighbor pairs than this assume every pair needs a shortcut instead of running
+// witness searches. These are the hubs, which rank near the top either way, and their searches dominate preprocessing.
+const long long ESTIMATE_PAIRS = 100;
+
+/**
+ * A shortcut u -> x through a contracted vertex
+ */
+struct Shortcut {
+    int source;
+    int target;
+    int weight;
+    int middle;
+};
+
+/**
+ * A Dijkstra search over the remaining graph that looks for a path between two neighbors of a vertex being
+ * contracted that avoids it. Keeps its arrays between searches and only resets the entries it touched.
+ */
+class WitnessSearch {
+    public:
+    WitnessSearch(int n) : dist(n, INT_MAX), target(n, 0), heap(n) { }
+
+    /**
+     * Runs from source, never entering avoid or a blocked vertex, until every target is settled, every vertex within
+     * maxDistance is settled, or limit vertices are settled. Giving up early only costs an unnecessary shortcut.
+     */
+    void run(const vector<vector<DynamicArc>>& out, int source, int avoid, const vector<char>& blocked, const vector<DynamicArc>& targets, int maxDistance, int limit) {
+        for (int v : touched) dist[v] = INT_MAX;
+        touched.clear();
+        heap.clear();
+
+        int unsettled = 0;
+        for (auto& arc : targets) {
+            if (arc.vertex != source && !target[arc.vertex]) unsettled++;
+            target[arc.vertex] = 1;
+        }
+        dist[source] = 0;
+        touched.push_back(source);
+        heap.push(source, 0);
+        int settled = 0;
+        while (!heap.empty() && unsettled > 0 && heap.topKey() <= maxDistance && settled < limit) {
+            int d = heap.topKey();
+            int current = heap.pop();
+            settled++;
+            if (target[current] && current != source) unsettled--;
+            for (auto& arc : out[current]) {
+                if (arc.vertex == avoid || blocked[arc.vertex] || d + arc.weight >= dist[arc.vertex]) continue;
+                if (dist[arc.vertex] == INT_MAX) touched.push_back(arc.vertex);
+                dist[arc.vertex] = d + arc.weight;
+                heap.push(arc.vertex, dist[arc.vertex]);
+            }
+        }
+        for (auto& arc : targets) target[arc.vertex] = 0;
+    }
+
+    int distance(int v) const { return dist[v]; }
+
+    private:
+    vector<int> dist;
+    vector<char> target;
+    vector<int> touched;
+    IndexedHeap<4> heap;
+};
+
+/**
+ * The graph while it is being contracted, holding only arcs between vertices that are not contracted yet
+ */
+struct Contraction {
+    vector<vector<DynamicArc>> out, in;
+
+    /**
+     * Finds the shortcuts contracting v needs: one for each pair of neighbors u -> v -> x without a shorter or equal witness path
+     */
+    vector<Shortcut> shortcuts(int v, WitnessSearch& search, const vector<char>& blocked, int limit) const {
+        vector<Shortcut> found;
+        int maxOut = 0;
+        for (auto& arc : out[v]) maxOut = max(maxOut, arc.weight);
+        for (auto& first : in[v]) {
+            search.run(out, first.vertex, v, blocked, out[v], first.weight + maxOut, limit);
+            for (auto& second : out[v]) {
+                if (second.vertex == first.vertex) continue;
+                int through = first.weight + second.weight;
+                if (search.distance(second.vertex) > through) found.push_back(Shortcut{first.vertex, second.vertex, through, v});
+            }
+        }
+        return found;
+    }
+
+    /**
+     * Adds an arc, or lowers the weight of an existing arc between the same two vertices
+     */
+    void addArc(int source, int target, int weight, int middle) {
+        auto lower = [&](vector<DynamicArc>& arcs, int vertex) {
+            for (auto& arc : arcs) {
+                if (arc.vertex != vertex) continue;
+                if (weight < arc.weight) arc = DynamicArc{vertex, weight, middle};
+                return;
+            }
+            arcs.push_back(DynamicArc{vertex, weight, middle});
+        };
+        lower(out[source], target);
+        lower(in[target], source);
+    }
+
+    /**
+     * Drops every arc between v and its neighbors
+     */
+    void remove(int v) {
+        auto drop = [v](vector<DynamicArc>& arcs) {
+            arcs.erase(std::remove_if(arcs.begin(), arcs.end(), [v](const DynamicArc& arc) { return arc.vertex == v; }), arcs.end());
+        };
+        for (auto& arc : in[v]) drop(out[arc.vertex]);
+        for (auto& arc : out[v]) drop(in[arc.vertex]);
+    }
+};
+
+/**
+ * Calls work(i, worker) for every i in [0, count) on the pool, or on the calling thread as worker 0 without one
+ */
+template <typename Work>
+void forEach(ThreadPool* pool, int count, Work work) {
+    if (pool == nullptr || pool->size() <= 1 || count < 64) {
+        for (int i = 0; i < count; i++) work(i, 0u);
+        return;
+    }
+    pool->parallelFor((size_t) count, [&](size_t begin, size_t end, unsigned worker) {
+        for (size_t i = begin; i < end; i++) work((int) i, worker);
+    }, 8);
+}
+
+/**
+ * Flattens per-vertex arc lists into CSR columns
+ */
+void flatten(const vector<vector<DynamicArc>>& arcs, Column<int>& offsets, Column<int>& vertices, Column<int>& weights, Column<int>& middles) {
+    vector<int> o(1, 0), v, w, m;
+    for (auto& row : arcs) {
+        for (auto& arc : row) {
+            v.push_back(arc.vertex);
+            w.push_back(arc.weight);
+            m.push_back(arc.middle);
+        }
+        o.push_back((int) v.size());
+    }
+    offsets = std::move(o);
+    vertices = std::move(v);
+    weights = std::move(w);
+    middles = std::move(m);
+}
+
+}
+
+ContractionHierarchy::ContractionHierarchy(const CSRGraph& graph, ThreadPool* pool) {
+    int n = graph.vertexCount();
+
+    // Start from the original routes without self loops, keeping only the lightest of parallel routes
+    Contraction g;
+    g.out.resize(n);
+    g.in.resize(n);
+    for (int u = 0; u < n; u++)
+        for (auto arc : graph.outgoing(u))
+            if (arc.vertex != u) g.addArc(u, arc.vertex, arc.weight, -1);
+
+    vector<WitnessSearch> searches(pool == nullptr ? 1 : max(1u, pool->size()), WitnessSearch(n));
+    vector<char> blocked(n, 0), contracted(n, 0);
+    vector<int> deleted(n, 0), priority(n, 0);
+    vector<int> order(n, -1);
+    vector<vector<DynamicArc>> up(n), down(n);
+
+    // Priority is the edge difference of contracting v now plus how many of its neighbors are already contracted
+    auto prioritize = [&](const vector<int>& vertices) {
+        forEach(pool, (int) vertices.size(), [&](int i, unsigned worker) {
+            int v = vertices[i];
+            long long pairs = (long long) g.in[v].size() * g.out[v].size();
+            int added = pairs > ESTIMATE_PAIRS ? (int) pairs : (int) g.shortcuts(v, searches[worker], blocked, SIMULATE_LIMIT).size();
+            priority[v] = added - (int) (g.in[v].size() + g.out[v].size()) + deleted[v];
+        });
+    };
+
+    vector<int> remaining(n);
+    for (int v = 0; v < n; v++) remaining[v] = v;
+    prioritize(remaining);
+
+    int nextRank = 0;
+    while (!remaining.empty()) {
+        // Contract every vertex that comes before all of its neighbors; no two of them are adjacent
+        auto before = [&](int a, int b) { return priority[a] < priority[b] || (priority[a] == priority[b] && a < b); };
+        vector<int> batch;
+        for (int v : remaining) {
+            bool minimal = true;
+            for (auto& arc : g.out[v]) minimal = minimal && before(v, arc.vertex);
+            for (auto& arc : g.in[v]) minimal = minimal && before(v, arc.vertex);
+            if (minimal) batch.push_back(v);
+        }
+
+        // Witness searches may not pass through any vertex of the batch, since they all disappear together
+        for (int v : batch) blocked[v] = 1;
+        vector<vector<Shortcut>> shortcuts(batch.size());
+        forEach(pool, (int) batch.size(), [&](int i, unsigned worker) {
+            shortcuts[i] = g.shortcuts(batch[i], searches[worker], blocked, CONTRACT_LIMIT);
+        });
+
+        vector<int> neighbors;
+        for (int v : batch) {
+            order[v] = nextRank++;
+            contracted[v] = 1;
+            up[v] = g.out[v];
+            down[v] = g.in[v];
+            for (auto& arc : g.out[v]) { deleted[arc.vertex]++; neighbors.push_back(arc.vertex); }
+            for (auto& arc : g.in[v]) { deleted[arc.vertex]++; neighbors.push_back(arc.vertex); }
+            g.remove(v);
+        }
+        for (auto& list : shortcuts)
+            for (auto& shortcut : list) g.addArc(shortcut.source, shortcut.target, shortcut.weight, shortcut.middle);
+        for (int v : batch) blocked[v] = 0;
+
+        remaining.erase(std::remove_if(remaining.begin(), remaining.end(), [&](int v) { return contracted[v]; }), remaining.end());
+        sort(neighbors.begin(), neighbors.end());
+        neighbors.erase(unique(neighbors.begin(), neighbors.end()), neighbors.end());
+        prioritize(neighbors);
+    }
+
+    rank = std::move(order);
+    flatten(up, upOffsets, upTargets, upWeights, upMiddles);
+    flatten(down, downOffsets, downSources, downWeights, downMiddles);
+}
+
+int ContractionHierarchy::shortcutCount() const {
+    int shortcuts = 0;
+    for (int m : upMiddles) shortcuts += m != -1;
+    for (int m : downMiddles) shortcuts += m != -1;
+    return shortcuts;
+}
+
+vector<int> ContractionHierarchy::query(int s, int t, int& settled, SearchWorkspace& workspace) const {
+    settled = 0;
+    workspace.reset(vertexCount());
+    IndexedHeap<4>& forward = workspace.heap();
+    IndexedHeap<4>& backward = workspace.reverseHeap();
+    auto dist = [&](bool isForward, int v) -> int& { return isForward ? workspace.dist(v) : workspace.backwardDist(v); };
+    auto parent = [&](bool isForward, int v) -> int& { return isForward ? workspace.parent(v) : workspace.backwardParent(v); };
+    dist(true, s) = 0;
+    dist(false, t) = 0;
+    forward.push(s, 0);
+    backward.push(t, 0);
+
+    long long best = s == t ? 0 : LLONG_MAX;
+    int meet = s == t ? s : -1;
+    while (true) {
+        // A side is done once nothing left in it can improve on the best path
+        bool forwardOpen = !forward.empty() && forward.topKey() < best;
+        bool backwardOpen = !backward.empty() && backward.topKey() < best;
+        if (!forwardOpen && !backwardOpen) break;
+        bool isForward = forwardOpen && (!backwardOpen || forward.topKey() <= backward.topKey());
+
+        IndexedHeap<4>& heap = isForward ? forward : backward;
+        const Column<int>& offsets = isForward ? upOffsets : downOffsets;
+        const Column<int>& vertices = isForward ? upTargets : downSources;
+        const Column<int>& weights = isForward ? upWeights : downWeights;
+
+        int d = heap.topKey();
+        int current = heap.pop();
+        settled++;
+        int other = isForward ? workspace.backwardDistOf(current) : workspace.distOf(current);
+        if (other != INT_MAX && (long long) d + other < best) {
+            best = (long long) d + other;
+            meet = current;
+        }
+
+        for (int i = offsets[current]; i < offsets[current + 1]; i++) {
+            int next = vertices[i], newDistance = d + weights[i];
+            if (newDistance < dist(isForward, next)) {
+                dist(isForward, next) = newDistance;
+                parent(isForward, next) = current;
+                heap.push(next, newDistance);
+            }
+        }
+    }
+    if (meet == -1) return vector<int>();
+
+    // Path in the hierarchy: up from s to the meeting vertex, then down to t
+    vector<int> hierarchyPath;
+    for (int v = meet; v != -1; v = parent(true, v)) hierarchyPath.push_back(v);
+    reverse(hierarchyPath.begin(), hierarchyPath.end());
+    for (int v = parent(false, meet); v != -1; v = parent(false, v)) hierarchyPath.push_back(v);
+
+    vector<int> path{s};
+    for (size_t i = 1; i < hierarchyPath.size(); i++) unpack(hierarchyPath[i - 1], hierarchyPath[i], path);
+    return path;
+}
+
+/**
+ * Runs Dijkstra from start over every upward arc, forward over up arcs or backward over down arcs, without stopping early
+ * @param dist Distance of every vertex, all INT_MAX on entry; only the reached entries are set on return
+ * @param reached Set to every vertex the search reached
+ * @param heap Empty heap sized to the vertex count, empty again on return
+ */
+void ContractionHierarchy::upwardSearch(int start, bool forward, vector<int>& dist, vector<int>& reached, IndexedHeap<4>& heap) const {
+    const Column<int>& offsets = forward ? upOffsets : downOffsets;
+    const Column<int>& vertices = forward ? upTargets : downSources;
+    const Column<int>& weights = forward ? upWeights : downWeights;
+    reached.clear();
+    dist[start] = 0;
+    reached.push_back(start);
+    heap.push(start, 0);
+    while (!heap.empty()) {
+        int d = heap.topKey();
+        int current = heap.pop();
+        for (int i = offsets[current]; i < offsets[current + 1]; i++) {
+            int next = vertices[i];
+            if (d + weights[i] < dist[next]) {
+                if (dist[next] == INT_MAX) reached.push_back(next);
+                dist[next] = d + weights[i];
+                heap.push(next, dist[next]);
+            }
+        }
+    }
+}
+
+vector<int> ContractionHierarchy::distanceMatrix(const vector<int>& sources, const vector<int>& targets) const {
+    int n = vertexCount();
+    vector<int> matrix(sources.size() * targets.size(), INT_MAX);
+    vector<int> dist(n, INT_MAX), reached;
+    IndexedHeap<4> heap(n);
+
+    // Bucket entries (vertex, target column, distance from the vertex down to the target), grouped by vertex
+    struct Entry { int vertex, column, distance; };
+    vector<Entry> entries;
+    for (int column = 0; column < (int) targets.size(); column++) {
+        if (targets[column] == -1) continue;
+        upwardSearch(targets[column], false, dist, reached, heap);
+        for (int v : reached) {
+            entries.push_back(Entry{v, column, dist[v]});
+            dist[v] = INT_MAX;
+        }
+    }
+    vector<int> bucketOffsets(n + 1, 0);
+    for (auto& entry : entries) bucketOffsets[entry.vertex + 1]++;
+    for (int v = 0; v < n; v++) bucketOffsets[v + 1] += bucketOffsets[v];
+    vector<int> next(bucketOffsets.begin(), bucketOffsets.end() - 1), bucketColumns(entries.size()), bucketDistances(entries.size());
+    for (auto& entry : entries) {
+        int slot = next[entry.vertex]++;
+        bucketColumns[slot] = entry.column;
+        bucketDistances[slot] = entry.distance;
+    }
+
+    // Every shortest path meets at its most important vertex, which both searches reach
+    for (int row = 0; row < (int) sources.size(); row++) {
+        if (sources[row] == -1) continue;
+        int* out = matrix.data() + (size_t) row * targets.size();
+        upwardSearch(sources[row], true, dist, reached, heap);
+        for (int v : reached) {
+            for (int i = bucketOffsets[v]; i < bucketOffsets[v + 1]; i++)
+                out[bucketColumns[i]] = min(out[bucketColumns[i]], dist[v] + bucketDistances[i]);
+            dist[v] = INT_MAX;
+        }
+    }
+    return matrix;
+}
+
+/**
+ * @return the vertex the arc a -> b skips, or -1 if it is an original route
+ */
+int ContractionHierarchy::middleOf(int a, int b) const {
+    if (rank[b] > rank[a]) {
+        for (int i = upOffsets[a]; i < upOffsets[a + 1]; i++)
+            if (upTargets[i] == b) return upMiddles[i];
+    } else {
+        for (int i = downOffsets[b]; i < downOffsets[b + 1]; i++)
+            if (downSources[i] == a) return downMiddles[i];
+    }
+    throw std::logic_error("Arc is missing from the hierarchy");
+}
+
+/**
+ * Appends every vertex after a on the original routes the arc a -> b stands for
+ */
+void ContractionHierarchy::unpack(int a, int b, vector<int>& path) const {
+    int middle = middleOf(a, b);
+    if (middle == -1) {
+        path.push_back(b);
+        return;
+    }
+    unpack(a, middle, path);
+    unpack(middle, b, path);
+}
+
+void ContractionHierarchy::save(SnapshotWriter& writer) const {
+    writer.column(rank);
+    writer.column(upOffsets);
+    writer.column(upTargets);
+    writer.column(upWeights);
+    writer.column(upMiddles);
+    writer.column(downOffsets);
+    writer.column(downSources);
+    writer.column(downWeights);
+    writer.column(downMiddles);
+}
+
+void ContractionHierarchy::load(SnapshotReader& reader) {
+    rank = reader.column<int>();
+    upOffsets = reader.column<int>();
+    upTargets = reader.column<int>();
+    upWeights = reader.column<int>();
+    upMiddles = reader.column<int>();
+    downOffsets = reader.column<int>();
+    downSources = reader.column<int>();
+    downWeights = reader.column<int>();
+    downMiddles = reader.column<int>();
+
+    // Reject arrays that would let a query read outside of them
+    size_t n = rank.size(), up = upTargets.size(), down = downSources.size();
+    if (upOffsets.size() != n + 1 || downOffsets.size() != n + 1 || upWeights.size() != up || upMiddles.size() != up
+        || downWeights.size() != down || downMiddles.size() != down
+        || !validRows(upOffsets, upTargets, n) || !validRows(downOffsets, downSources, n))
+        throw std::runtime_error("Snapshot hierarchy arrays are inconsistent");
+    for (size_t i = 0; i < up + down; i++) {
+        int middle = i < up ? upMiddles[i] : downMiddles[i - up];
+        if (middle < -1 || middle >= (int) n) throw std::runtime_error("Snapshot hierarchy arrays are inconsistent");
+    }
+}
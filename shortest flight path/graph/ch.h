@@ -0,0 +1,102 @@
+/**
+ * @file ch.h
+ */
+
+#pragma once
+
+#include "column.h"
+#include "csr.h"
+#include "heap.h"
+#include "threadpool.h"
+#include "workspace.h"
+
+#include <vector>
+
+using std::vector;
+
+class SnapshotWriter;
+class SnapshotReader;
+
+/**
+ * A Contraction Hierarchy over a CSRGraph for fast point-to-point queries.
+ * Airports are contracted one after another in order of importance; contracting an airport adds a shortcut
+ * between two of its remaining neighbors whenever the only shortest path between them runs through it.
+ * A query then only follows arcs towards more important airports from both ends, and shortcuts on the
+ * resulting path are expanded back into the original routes through the airport each one skips.
+ */
+class ContractionHierarchy {
+    public:
+
+    /**
+     * Default constructor, holds no hierarchy
+     */
+    ContractionHierarchy() : upOffsets(vector<int>(1, 0)), downOffsets(vector<int>(1, 0)) { }
+
+    /**
+     * Orders and contracts every vertex of a graph.
+     * Vertices are contracted in rounds: each round takes every vertex whose priority (edge difference plus
+     * number of contracted neighbors) is lower than that of all its neighbors, runs the witness searches of those
+     * vertices in parallel, and then applies their shortcuts.
+     * @param graph Graph to contract
+     * @param pool Pool to run witness searches on, or nullptr to run them on the calling thread
+     */
+    ContractionHierarchy(const CSRGraph& graph, ThreadPool* pool = nullptr);
+
+    /**
+     * @return the number of vertices in the hierarchy
+     */
+    int vertexCount() const { return (int) rank.size(); }
+
+    /**
+     * @return the number of shortcut arcs added by contraction
+     */
+    int shortcutCount() const;
+
+    /**
+     * @param v Dense index
+     * @return the position of v in the contraction order, higher is more important
+     */
+    int rankOf(int v) const { return rank[v]; }
+
+    /**
+     * Finds a shortest path with a bidirectional search that only moves up the hierarchy
+     * @param s Dense index of the source
+     * @param t Dense index of the destination
+     * @param settled Set to the number of vertices settled by both searches
+     * @param workspace Scratch arrays for both searches, reset first
+     * @return the dense indices on a shortest path from s to t with every shortcut expanded, empty if there is none
+     */
+    vector<int> query(int s, int t, int& settled, SearchWorkspace& workspace) const;
+
+    /**
+     * Computes the shortest distance between every source and every target with one upward search per airport.
+     * A backward search from each target leaves its distance in a bucket at every vertex it reaches, and a forward
+     * search from each source then only scans the buckets of the vertices it reaches.
+     * @param sources Dense indices of the sources, -1 for an unknown airport
+     * @param targets Dense indices of the targets, -1 for an unknown airport
+     * @return a row-major sources.size() by targets.size() matrix of distances, INT_MAX where there is no path
+     */
+    vector<int> distanceMatrix(const vector<int>& sources, const vector<int>& targets) const;
+
+    void save(SnapshotWriter& writer) const;
+    void load(SnapshotReader& reader);
+
+    private:
+    Column<int> rank;
+
+    // Arcs v -> x with rank[x] > rank[v], stored at v; middle is the vertex a shortcut skips, -1 for an original route
+    Column<int> upOffsets;
+    Column<int> upTargets;
+    Column<int> upWeights;
+    Column<int> upMiddles;
+
+    // Arcs u -> v with rank[u] > rank[v], stored at v so the backward search can walk them from v to u
+    Column<int> downOffsets;
+    Column<int> downSources;
+    Column<int> downWeights;
+    Column<int> downMiddles;
+
+    int middleOf(int a, int b) const;
+    void upwardSearch(int start, bool forward, vector<int>& dist, vector<int>& reached, IndexedHeap<4>& heap) const;
+    void unpack(int a, int b, vector<int>& path) const;
+};
@@ -0,0 +1,71 @@
+/**
+ * @file column.h
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+using std::shared_ptr;
+using std::vector;
+
+/**
+ * A flat array that either owns its elements or borrows them from memory kept alive by someone else,
+ * such as a memory-mapped snapshot file. Borrowed columns are read-only until edit() copies them.
+ */
+template <typename T>
+class Column {
+    public:
+
+    /**
+     * Default constructor, creates an empty owned column
+     */
+    Column() { }
+
+    /**
+     * Creates a column owning the given elements
+     * @param values Elements to take ownership of
+     */
+    Column(vector<T> values) : owned(std::move(values)) { }
+
+    /**
+     * Creates a column that reads elements it does not own
+     * @param data First element
+     * @param size Number of elements
+     * @param backing Keeps the memory holding the elements alive for as long as the column exists
+     */
+    static Column borrow(const T* data, size_t size, shared_ptr<const void> backing) {
+        Column column;
+        column.borrowed = data;
+        column.count = size;
+        column.backing = std::move(backing);
+        return column;
+    }
+
+    const T* data() const { return backing ? borrowed : owned.data(); }
+    size_t size() const { return backing ? count : owned.size(); }
+    bool empty() const { return size() == 0; }
+    const T& operator[](size_t i) const { return data()[i]; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + size(); }
+
+    /**
+     * Returns the elements for modification, first copying them if they are borrowed
+     * @return the owned elements
+     */
+    vector<T>& edit() {
+        if (backing) {
+            owned.assign(borrowed, borrowed + count);
+            backing.reset();
+            borrowed = nullptr;
+        }
+        return owned;
+    }
+
+    private:
+    vector<T> owned;
+    const T* borrowed = nullptr;
+    size_t count = 0;
+    shared_ptr<const void> backing;
+};
@@ -0,0 +1,146 @@
+#include "csr.h"
+#include "snapshot.h"
+
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+
+/**
+ * Builds the forward and reverse arrays with a stable counting sort on each edge's source and target
+ * @param vertexCount Number of rows; every edge endpoint must be in [0, vertexCount)
+ * @param edges Edges to store
+ */
+CSRGraph::CSRGraph(int vertexCount, const vector<Edge>& edges) {
+    vector<int> outOffsets(vertexCount + 1, 0), inOffsets(vertexCount + 1, 0);
+
+    // Count the degree of every vertex, shifted by one so the prefix sum lands on the row starts
+    for (auto& edge : edges) {
+        outOffsets[edge.source + 1]++;
+        inOffsets[edge.target + 1]++;
+    }
+    for (int v = 0; v < vertexCount; v++) {
+        outOffsets[v + 1] += outOffsets[v];
+        inOffsets[v + 1] += inOffsets[v];
+    }
+
+    vector<Vertex> outTargets(edges.size()), inSources(edges.size());
+    vector<int> outWeights(edges.size()), inWeights(edges.size());
+
+    // Scatter each edge into the next free slot of its rows
+    vector<int> outNext(outOffsets.begin(), outOffsets.end() - 1);
+    vector<int> inNext(inOffsets.begin(), inOffsets.end() - 1);
+    for (auto& edge : edges) {
+        int o = outNext[edge.source]++;
+        outTargets[o] = edge.target;
+        outWeights[o] = edge.getWeight();
+
+        int i = inNext[edge.target]++;
+        inSources[i] = edge.source;
+        inWeights[i] = edge.getWeight();
+    }
+
+    this->outOffsets = std::move(outOffsets);
+    this->outTargets = std::move(outTargets);
+    this->outWeights = std::move(outWeights);
+    this->inOffsets = std::move(inOffsets);
+    this->inSources = std::move(inSources);
+    this->inWeights = std::move(inWeights);
+}
+
+vector<Edge> CSRGraph::edges() const {
+    vector<Edge> all;
+    all.reserve(edgeCount());
+    for (Vertex v = 0; v < vertexCount(); v++)
+        for (auto arc : outgoing(v)) all.push_back(Edge(v, arc.vertex, arc.weight));
+    return all;
+}
+
+int CSRGraph::weight(Vertex u, Vertex v) const {
+    int lightest = INT_MAX;
+    for (auto arc : outgoing(u))
+        if (arc.vertex == v) lightest = std::min(lightest, arc.weight);
+    return lightest;
+}
+
+void CSRGraph::addArc(Vertex u, Vertex v, int weight) {
+    vector<int>& oo = outOffsets.edit();
+    vector<Vertex>& ot = outTargets.edit();
+    vector<int>& ow = outWeights.edit();
+    ot.insert(ot.begin() + oo[u + 1], v);
+    ow.insert(ow.begin() + oo[u + 1], weight);
+    for (size_t x = u + 1; x < oo.size(); x++) oo[x]++;
+
+    vector<int>& io = inOffsets.edit();
+    vector<Vertex>& is = inSources.edit();
+    vector<int>& iw = inWeights.edit();
+    is.insert(is.begin() + io[v + 1], u);
+    iw.insert(iw.begin() + io[v + 1], weight);
+    for (size_t x = v + 1; x < io.size(); x++) io[x]++;
+}
+
+namespace {
+
+/**
+ * Removes the arcs of one row whose neighbor is other, then shifts the offsets of the rows after it
+ * @return the number of arcs removed
+ */
+int removeFromRow(vector<int>& offsets, vector<Vertex>& neighbors, vector<int>& weights, Vertex row, Vertex other) {
+    int begin = offsets[row], end = offsets[row + 1], kept = begin;
+    for (int i = begin; i < end; i++) {
+        if (neighbors[i] == other) continue;
+        neighbors[kept] = neighbors[i];
+        weights[kept] = weights[i];
+        kept++;
+    }
+    int removed = end - kept;
+    if (removed == 0) return 0;
+    neighbors.erase(neighbors.begin() + kept, neighbors.begin() + end);
+    weights.erase(weights.begin() + kept, weights.begin() + end);
+    for (size_t x = row + 1; x < offsets.size(); x++) offsets[x] -= removed;
+    return removed;
+}
+
+}
+
+int CSRGraph::removeArcs(Vertex u, Vertex v) {
+    if (weight(u, v) == INT_MAX) return 0;
+    int removed = removeFromRow(outOffsets.edit(), outTargets.edit(), outWeights.edit(), u, v);
+    removeFromRow(inOffsets.edit(), inSources.edit(), inWeights.edit(), v, u);
+    return removed;
+}
+
+int CSRGraph::reweightArcs(Vertex u, Vertex v, int weight) {
+    if (this->weight(u, v) == INT_MAX) return 0;
+    vector<int>& ow = outWeights.edit();
+    vector<int>& iw = inWeights.edit();
+    int changed = 0;
+    for (int i = outOffsets[u]; i < outOffsets[u + 1]; i++)
+        if (outTargets[i] == v) { ow[i] = weight; changed++; }
+    for (int i = inOffsets[v]; i < inOffsets[v + 1]; i++)
+        if (inSources[i] == u) iw[i] = weight;
+    return changed;
+}
+
+void CSRGraph::save(SnapshotWriter& writer) const {
+    writer.column(outOffsets);
+    writer.column(outTargets);
+    writer.column(outWeights);
+    writer.column(inOffsets);
+    writer.column(inSources);
+    writer.column(inWeights);
+}
+
+void CSRGraph::load(SnapshotReader& reader) {
+    outOffsets = reader.column<int>();
+    outTargets = reader.column<Vertex>();
+    outWeights = reader.column<int>();
+    inOffsets = reader.column<int>();
+    inSources = reader.column<Vertex>();
+    inWeights = reader.column<int>();
+
+    // Reject arrays that would let a traversal read outside of them
+    size_t m = outTargets.size(), n = outOffsets.size() - 1;
+    if (outOffsets.empty() || inOffsets.size() != outOffsets.size() || outWeights.size() != m || inSources.size() != m || inWeights.size() != m
+        || !validRows(outOffsets, outTargets, n) || !validRows(inOffsets, inSources, n))
+        throw std::runtime_error("Snapshot edge arrays are inconsistent");
+}
@@ -0,0 +1,161 @@
+/**
+ * @file csr.h
+ */
+
+#pragma once
+
+#include "column.h"
+#include "edge.h"
+
+#include <vector>
+
+using std::vector;
+
+class SnapshotWriter;
+class SnapshotReader;
+
+/**
+ * A neighboring vertex reached over one edge, along with the weight of that edge
+ */
+struct Arc {
+    Vertex vertex;
+    int weight;
+};
+
+/**
+ * A read-only view over the contiguous run of arcs stored for one vertex in a CSRGraph.
+ * Iterating it walks the underlying target and weight arrays directly without copying.
+ */
+class ArcRange {
+    public:
+
+    class iterator {
+        public:
+        iterator(const Vertex* v, const int* w) : vertex(v), weight(w) { }
+        Arc operator*() const { return Arc{*vertex, *weight}; }
+        iterator& operator++() { ++vertex; ++weight; return *this; }
+        bool operator!=(const iterator& other) const { return vertex != other.vertex; }
+        bool operator==(const iterator& other) const { return vertex == other.vertex; }
+
+        private:
+        const Vertex* vertex;
+        const int* weight;
+    };
+
+    /**
+     * Parameterized constructor
+     * @param vertices_ First neighboring vertex of the run
+     * @param weights_ Weight of the first arc of the run
+     * @param count_ Number of arcs in the run
+     */
+    ArcRange(const Vertex* vertices_, const int* weights_, int count_) : vertices(vertices_), weights(weights_), count(count_) { }
+
+    iterator begin() const { return iterator(vertices, weights); }
+    iterator end() const { return iterator(vertices + count, weights + count); }
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    Arc operator[](int i) const { return Arc{vertices[i], weights[i]}; }
+
+    private:
+    const Vertex* vertices;
+    const int* weights;
+    int count;
+};
+
+/**
+ * A Compressed Sparse Row copy of a graph's edges, edited in place only by the single-arc updates below.
+ * The outgoing arcs of vertex v are targets[offsets[v] .. offsets[v + 1]) with matching weights,
+ * and a second set of arrays stores the incoming arcs the same way so backward scans are also contiguous.
+ */
+class CSRGraph {
+    public:
+
+    /**
+     * Default constructor, creates a graph with no vertices
+     */
+    CSRGraph() : outOffsets(vector<int>(1, 0)), inOffsets(vector<int>(1, 0)) { }
+
+    /**
+     * Builds the forward and reverse arrays from a list of edges.
+     * Arcs of each vertex keep the relative order they have in edges.
+     * @param vertexCount Number of rows; every edge endpoint must be in [0, vertexCount)
+     * @param edges Edges to store
+     */
+    CSRGraph(int vertexCount, const vector<Edge>& edges);
+
+    /**
+     * @param v Vertex to look up
+     * @return the arcs leaving v
+     */
+    ArcRange outgoing(Vertex v) const {
+        return ArcRange(outTargets.data() + outOffsets[v], outWeights.data() + outOffsets[v], outOffsets[v + 1] - outOffsets[v]);
+    }
+
+    /**
+     * @param v Vertex to look up
+     * @return the arcs entering v, where each arc's vertex is the edge's source
+     */
+    ArcRange incoming(Vertex v) const {
+        return ArcRange(inSources.data() + inOffsets[v], inWeights.data() + inOffsets[v], inOffsets[v + 1] - inOffsets[v]);
+    }
+
+    /**
+     * @return the number of rows in the graph
+     */
+    int vertexCount() const { return (int) outOffsets.size() - 1; }
+
+    /**
+     * @return the number of edges in the graph
+     */
+    int edgeCount() const { return (int) outTargets.size(); }
+
+    /**
+     * @return every edge, grouped by source in row order
+     */
+    vector<Edge> edges() const;
+
+    /**
+     * @param u Source vertex
+     * @param v Target vertex
+     * @return the weight of the lightest arc from u to v, or INT_MAX if there is none
+     */
+    int weight(Vertex u, Vertex v) const;
+
+    /**
+     * Appends an arc to the end of u's outgoing row and v's incoming row, shifting the later rows in place.
+     * Costs O(V + E) memory moves but no re-sort; borrowed arrays are copied first.
+     * @param u Source vertex
+     * @param v Target vertex
+     * @param weight Weight of the arc
+     */
+    void addArc(Vertex u, Vertex v, int weight);
+
+    /**
+     * Removes every arc from u to v, shifting the later rows in place
+     * @param u Source vertex
+     * @param v Target vertex
+     * @return the number of arcs removed
+     */
+    int removeArcs(Vertex u, Vertex v);
+
+    /**
+     * Sets the weight of every arc from u to v in place
+     * @param u Source vertex
+     * @param v Target vertex
+     * @param weight New weight
+     * @return the number of arcs changed
+     */
+    int reweightArcs(Vertex u, Vertex v, int weight);
+
+    void save(SnapshotWriter& writer) const;
+    void load(SnapshotReader& reader);
+
+    private:
+    Column<int> outOffsets;
+    Column<Vertex> outTargets;
+    Column<int> outWeights;
+
+    Column<int> inOffsets;
+    Column<Vertex> inSources;
+    Column<int> inWeights;
+};
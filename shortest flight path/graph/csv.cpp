@@ -0,0 +1,181 @@
+#include "csv.h"
+
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) throw std::invalid_argument("Incorrect filepath");
+
+    struct stat info;
+    if (fstat(fd, &info) == -1) {
+        close(fd);
+        throw std::invalid_argument("Incorrect filepath");
+    }
+    length = (size_t) info.st_size;
+
+    // mmap rejects empty mappings, so an empty file is left as an empty range
+    if (length > 0) {
+        void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            close(fd);
+            throw std::invalid_argument("Could not map " + path);
+        }
+        madvise(mapping, length, MADV_SEQUENTIAL);
+        data = (const char*) mapping;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data) munmap((void*) data, length);
+}
+
+/**
+ * Finds the first comma or newline in [p, end), testing eight bytes per step
+ * @param p First byte to search
+ * @param end One past the last byte to search
+ * @return pointer to the delimiter, or end if there is none
+ */
+static inline const char* findDelimiter(const char* p, const char* end) {
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    const uint64_t ones = 0x0101010101010101ULL, highs = 0x8080808080808080ULL;
+    const uint64_t commas = ones * ',', newlines = ones * '\n';
+    while (end - p >= 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+
+        // A byte of x is zero exactly where word matched the delimiter; flag the high bit of those bytes
+        uint64_t a = word ^ commas, b = word ^ newlines;
+        uint64_t hits = ((a - ones) & ~a & highs) | ((b - ones) & ~b & highs);
+        if (hits) return p + (__builtin_ctzll(hits) >> 3);
+        p += 8;
+    }
+#endif
+    while (p < end && *p != ',' && *p != '\n') p++;
+    return p;
+}
+
+/**
+ * Reads a field that starts with a quote
+ * @param p The opening quote
+ * @param field Field number to fill
+ * @return pointer to the delimiter that ends the field, or end
+ */
+const char* CSVReader::readQuoted(const char* p, int field) {
+    const char* start = ++p;
+    const char* close = end;
+    bool escaped = false;
+
+    // Jump from quote to quote; a doubled quote is an escaped quote inside the field
+    while (p < end) {
+        const char* quote = (const char*) memchr(p, '"', end - p);
+        if (!quote) break;
+        if (quote + 1 < end && quote[1] == '"') {
+            escaped = true;
+            p = quote + 2;
+            continue;
+        }
+        close = quote;
+        break;
+    }
+
+    if (field < MAX_FIELDS) {
+        nulls[field] = false;
+        if (escaped) {
+            // Copy the field into scratch, collapsing each "" to "
+            scratchOffset[field] = (int) scratch.size();
+            for (const char* c = start; c < close; c++) {
+                scratch.push_back(*c);
+                if (*c == '"') c++;
+            }
+            scratchLength[field] = (int) scratch.size() - scratchOffset[field];
+        } else {
+            scratchOffset[field] = -1;
+            fields[field] = string_view(start, close - start);
+        }
+    }
+
+    // Ignore anything between the closing quote and the next delimiter, such as a carriage return
+    return close < end ? findDelimiter(close + 1, end) : end;
+}
+
+/**
+ * Reads a field that does not start with a quote
+ * @param p First byte of the field
+ * @param field Field number to fill
+ * @return pointer to the delimiter that ends the field, or end
+ */
+const char* CSVReader::readUnquoted(const char* p, int field) {
+    const char* delimiter = findDelimiter(p, end);
+    const char* last = delimiter;
+    if (last > p && last[-1] == '\r' && (last == end || *last == '\n')) last--;
+
+    if (field < MAX_FIELDS) {
+        string_view value(p, last - p);
+        scratchOffset[field] = -1;
+        nulls[field] = value == "\\N";
+        fields[field] = nulls[field] ? string_view() : value;
+    }
+    return delimiter;
+}
+
+bool CSVReader::next() {
+    while (cursor < end) {
+        // Skip blank lines
+        if (*cursor == '\n') { cursor++; continue; }
+        if (*cursor == '\r' && cursor + 1 < end && cursor[1] == '\n') { cursor += 2; continue; }
+
+        count = 0;
+        scratch.clear();
+        const char* p = cursor;
+        while (true) {
+            p = *p == '"' ? readQuoted(p, count) : readUnquoted(p, count);
+            count++;
+            if (p < end && *p == ',') {
+                p++;
+                // A trailing comma ends the record with one empty field
+                if (p == end || *p == '\n') {
+                    if (count < MAX_FIELDS) { fields[count] = string_view(); nulls[count] = false; scratchOffset[count] = -1; }
+                    count++;
+                } else continue;
+            }
+            break;
+        }
+        cursor = p < end ? p + 1 : end;
+        if (count > MAX_FIELDS) count = MAX_FIELDS;
+
+        // Point unescaped fields at scratch now that it will not grow again for this record
+        for (int i = 0; i < count; i++)
+            if (scratchOffset[i] != -1) fields[i] = string_view(scratch.data() + scratchOffset[i], scratchLength[i]);
+        return true;
+    }
+    return false;
+}
+
+bool parseInt(string_view field, int& out) {
+    auto result = std::from_chars(field.data(), field.data() + field.size(), out);
+    return result.ec == std::errc() && result.ptr == field.data() + field.size() && !field.empty();
+}
+
+bool parseDouble(string_view field, double& out) {
+    // Copy into a small stack buffer so strtod sees a terminated string; numeric fields are short
+    char buffer[64];
+    if (field.empty() || field.size() >= sizeof(buffer)) return false;
+    memcpy(buffer, field.data(), field.size());
+    buffer[field.size()] = '\0';
+
+    char* parsed;
+    out = strtod(buffer, &parsed);
+    return parsed == buffer + field.size();
+}
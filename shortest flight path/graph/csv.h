@@ -0,0 +1,125 @@
+/**
+ * @file csv.h
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+using std::string;
+using std::string_view;
+
+/**
+ * A read-only memory mapping of a whole file. The mapping is released when the object is destroyed.
+ */
+class MappedFile {
+    public:
+
+    /**
+     * Maps a file into memory
+     * @param path Path to the file
+     * @throws std::invalid_argument if the file cannot be opened or mapped
+     */
+    MappedFile(const string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @return the first byte of the file
+     */
+    const char* begin() const { return data; }
+
+    /**
+     * @return one past the last byte of the file
+     */
+    const char* end() const { return data + length; }
+
+    /**
+     * @return the size of the file in bytes
+     */
+    size_t size() const { return length; }
+
+    private:
+    const char* data = nullptr;
+    size_t length = 0;
+};
+
+/**
+ * Splits a buffer of RFC 4180 comma separated records into fields.
+ * Fields may be wrapped in double quotes, in which case they can contain commas and newlines,
+ * and a doubled quote ("") inside them stands for one quote. The OpenFlights null marker \N reads as an empty field.
+ * Fields are string_views into the buffer; only fields holding escaped quotes are unescaped into a
+ * reused scratch buffer, so steady-state parsing allocates nothing per record.
+ */
+class CSVReader {
+    public:
+
+    /**
+     * Most fields kept per line; later fields on a longer line are dropped
+     */
+    static const int MAX_FIELDS = 16;
+
+    /**
+     * Parameterized constructor
+     * @param begin_ First byte of the buffer
+     * @param end_ One past the last byte of the buffer
+     */
+    CSVReader(const char* begin_, const char* end_) : cursor(begin_), end(end_) { }
+
+    /**
+     * Splits the next non-empty record into fields
+     * @return false once the buffer is exhausted
+     */
+    bool next();
+
+    /**
+     * @return the number of fields on the current record
+     */
+    int size() const { return count; }
+
+    /**
+     * @param i Field number
+     * @return the i-th field of the current record without its quotes, or an empty view if the record is shorter or the field is \N
+     */
+    string_view operator[](int i) const { return i < count ? fields[i] : string_view(); }
+
+    /**
+     * @param i Field number
+     * @return true if the i-th field is the null marker \N or missing
+     */
+    bool isNull(int i) const { return i >= count || nulls[i]; }
+
+    private:
+    const char* cursor;
+    const char* end;
+    string_view fields[MAX_FIELDS];
+    bool nulls[MAX_FIELDS];
+    int count = 0;
+
+    // Unescaped copies of quoted fields that contained "", addressed by offset until the record is complete
+    string scratch;
+    int scratchOffset[MAX_FIELDS];
+    int scratchLength[MAX_FIELDS];
+
+    const char* readQuoted(const char* p, int field);
+    const char* readUnquoted(const char* p, int field);
+};
+
+/**
+ * Parses a whole field as a base 10 integer
+ * @param field Field to parse
+ * @param out Set to the parsed value on success
+ * @return true if the entire field is an integer
+ */
+bool parseInt(string_view field, int& out);
+
+/**
+ * Parses a whole field as a floating point number, rounding exactly as std::stod does
+ * @param field Field to parse
+ * @param out Set to the parsed value on success
+ * @return true if the entire field is a number
+ */
+bool parseDouble(string_view field, double& out);
@@ -21,7 +21,7 @@ class Airport {
     /**
      * Default constructor
      */
-    Airport() { }
+    Airport() : latitude(0), longitude(0), code(-1) { }
     /**
      * Parameterized constructor
      */
@@ -32,49 +32,49 @@ class Airport {
      * Returns the airport's name
      * @return name
      */
-    string getName() { return name; }
+    string getName() const { return name; }
 
     /**
      * Returns the airport's city
      * @return city
      */
-    string getCity() { return city; }
+    string getCity() const { return city; }
 
     /**
      * Returns the airport's country
      * @return country
      */
-    string getCountry() { return country; }
+    string getCountry() const { return country; }
 
     /**
      * Returns the airport's IATA code
      * @return IATA
      */
-    string getIATA() { return IATA; }
+    string getIATA() const { return IATA; }
 
     /**
      * Returns the airport's ICAO code
      * @return ICAO
      */
-    string getICAO() { return ICAO; }
+    string getICAO() const { return ICAO; }
 
     /**
      * Returns the airport's latitude
      * @return latitude
      */
-    double getLatitude() { return latitude; }
+    double getLatitude() const { return latitude; }
 
     /**
      * Returns the airport's longitude
      * @return longitude
      */
-    double getLongitude() { return longitude; }
+    double getLongitude() const { return longitude; }
 
     /**
      * Returns the airport's code
      * @return code
      */
-    int getCode() { return code; }
+    int getCode() const { return code; }
     
     private:
 
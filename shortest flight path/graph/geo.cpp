@@ -0,0 +1,26 @@
+#include "geo.h"
+
+#include <algorithm>
+#include <cmath>
+
+static const double earthRadiusKm = 6371.0;
+
+SpherePoints::SpherePoints(const AirportTable& airports) {
+    xyz.resize(3 * airports.size());
+    for (int i = 0; i < airports.size(); i++) {
+        double lat = airports.latitude(i) * M_PI / 180, lon = airports.longitude(i) * M_PI / 180;
+        xyz[3 * i] = cos(lat) * cos(lon);
+        xyz[3 * i + 1] = cos(lat) * sin(lon);
+        xyz[3 * i + 2] = sin(lat);
+    }
+}
+
+double SpherePoints::distance(int a, int b) const {
+    const double* p = &xyz[3 * a];
+    const double* q = &xyz[3 * b];
+    double dx = p[0] - q[0], dy = p[1] - q[1], dz = p[2] - q[2];
+
+    // The chord between two unit vectors subtends the angle 2 asin(chord / 2)
+    double chord = sqrt(dx * dx + dy * dy + dz * dz);
+    return 2.0 * earthRadiusKm * asin(std::min(1.0, chord / 2));
+}
@@ -0,0 +1,46 @@
+/**
+ * @file geo.h
+ */
+
+#pragma once
+
+#include "airports.h"
+
+#include <vector>
+
+using std::vector;
+
+/**
+ * Every airport's position as a unit vector on the sphere, indexed by dense airport index.
+ * A great-circle distance then costs a chord length and one arcsine instead of the per-call
+ * degree conversions and trig that Graph::distanceEarth does on latitudes and longitudes.
+ */
+class SpherePoints {
+    public:
+
+    /**
+     * Default constructor, holds no airports
+     */
+    SpherePoints() { }
+
+    /**
+     * Converts the latitude and longitude of every airport in a table
+     * @param airports Airports to convert
+     */
+    SpherePoints(const AirportTable& airports);
+
+    /**
+     * @return the number of airports
+     */
+    int size() const { return (int) xyz.size() / 3; }
+
+    /**
+     * @param a Dense index of the first airport
+     * @param b Dense index of the second airport
+     * @return the great-circle distance between the two airports in kilometers
+     */
+    double distance(int a, int b) const;
+
+    private:
+    vector<double> xyz;
+};
@@ -1,14 +1,17 @@
 #include "graph.h"
+#include "csv.h"
+#include "snapshot.h"
 
 #include <math.h>
 #include <cmath> 
 #include <algorithm>
+#include <climits>
+#include <cstring>
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <string>
 #include <stdexcept>
 #include <queue>
+#include <thread>
 #include <map>
 
 #define earthRadiusKm 6371.0
@@ -31,8 +34,215 @@ Graph::Graph(string airport_path, string route_path) {
     // Read the airport CSV and initialize vertexes
     readAirportCSV(airport_path);
 
-    // Read route CSV and create edges between vertexes
-    for (auto i : readRouteCSV(route_path)) insertEdge((int) i[0], (int) i[1], i[2]);    
+    // Read route CSV on every core and create edges between vertexes
+    loadRouteCSV(route_path, thread::hardware_concurrency());
+
+    // Build the contiguous edge arrays used by the traversals
+    freeze();
+}
+
+/**
+ * Construct a graph from a binary snapshot if it is up to date with the two CSV files,
+ * otherwise parse the CSV files, prepare ALT landmarks, the Contraction Hierarchy and hub labels, and write a fresh snapshot for next time
+ * @param airport_path path to the Airport CSV file
+ * @param route_path path to the Route CSV file
+ * @param snapshot_path path to the snapshot file
+ */
+Graph::Graph(string airport_path, string route_path, string snapshot_path) {
+    if (readSnapshot(snapshot_path, airport_path, route_path)) return;
+
+    readAirportCSV(airport_path);
+    loadRouteCSV(route_path, thread::hardware_concurrency());
+    freeze();
+    prepareLandmarks();
+    prepareContractionHierarchy();
+    prepareHubLabels();
+
+    // A snapshot we cannot write only costs the next run a CSV parse
+    try {
+        writeSnapshot(snapshot_path, airport_path, route_path);
+    } catch (std::exception& e) { }
+}
+
+/**
+ * Builds the Compressed Sparse Row arrays used by BFS and Dijkstra from the edges already frozen plus every edge inserted since.
+ * Called once after construction; insertEdge marks the arrays stale and getCSR rebuilds them on demand.
+ */
+void Graph::freeze() {
+    vector<Edge> edges = csr.edges();
+    edges.insert(edges.end(), pending_edges.begin(), pending_edges.end());
+    csr = CSRGraph(ids.size(), edges);
+    pending_edges.clear();
+    ids.finalize();
+    frozen = true;
+    sphereStale = true;
+    discardPreprocessing();
+    trees.clear();
+}
+
+/**
+ * Drops the structures built from the edges that an edge update cannot patch
+ */
+void Graph::discardPreprocessing() {
+    landmarks = Landmarks();
+    hierarchy = ContractionHierarchy();
+    labels = HubLabels();
+}
+
+void Graph::addRoute(Vertex source, Vertex target, double weight) {
+    int s = indexOf(source), t = indexOf(target);
+    if (s == -1 || t == -1) throw invalid_argument("Route endpoints must be known airports");
+    if (weight < 0) throw invalid_argument("Route weight must not be negative");
+
+    // Truncate the way an Edge built by insertEdge does, so the repaired trees match ones rebuilt from scratch
+    int kilometers = Edge(s, t, weight).getWeight();
+    getCSR();
+    int before = csr.weight(s, t);
+    csr.addArc(s, t, kilometers);
+    edgeCount++;
+    routeChanged(s, t, before, min(before, kilometers));
+}
+
+bool Graph::removeRoute(Vertex source, Vertex target) {
+    int s = indexOf(source), t = indexOf(target);
+    if (s == -1 || t == -1) return false;
+
+    getCSR();
+    int before = csr.weight(s, t);
+    int removed = csr.removeArcs(s, t);
+    if (removed == 0) return false;
+    edgeCount -= removed;
+    routeChanged(s, t, before, INT_MAX);
+    return true;
+}
+
+bool Graph::setRouteWeight(Vertex source, Vertex target, double weight) {
+    int s = indexOf(source), t = indexOf(target);
+    if (s == -1 || t == -1) return false;
+    if (weight < 0) throw invalid_argument("Route weight must not be negative");
+
+    int kilometers = Edge(s, t, weight).getWeight();
+    getCSR();
+    int before = csr.weight(s, t);
+    if (csr.reweightArcs(s, t, kilometers) == 0) return false;
+    routeChanged(s, t, before, kilometers);
+    return true;
+}
+
+/**
+ * Brings everything built from the edges up to date after the lightest arc from s to t changed weight
+ * @param s dense index of the source airport
+ * @param t dense index of the target airport
+ * @param before weight of the lightest arc before the update, INT_MAX if there was none
+ * @param after weight of the lightest arc after the update, INT_MAX if there is none
+ */
+void Graph::routeChanged(int s, int t, int before, int after) {
+    discardPreprocessing();
+    if (before == after) return;
+
+    // A route shorter than the straight line between its airports lowers the A* scale; it never has to rise
+    if (after < before && !sphereStale) {
+        double straight = sphere.distance(s, t);
+        if (straight > after) sphereScale = min(sphereScale, after / straight * (1 - 1e-9));
+    }
+
+    // Trees the update cannot affect are kept as they are; the rest are copied, since readers may still hold them
+    trees.update([&](const shared_ptr<const ShortestPathTree>& tree) -> shared_ptr<const ShortestPathTree> {
+        bool affected = after < before ? tree->dist[s] != INT_MAX && tree->dist[s] + after < tree->dist[t] : tree->parent[t] == s;
+        if (!affected) return tree;
+        shared_ptr<ShortestPathTree> repaired = make_shared<ShortestPathTree>(*tree);
+        if (after < before) relaxArc(csr, *repaired, s, t, after, workspace);
+        else repairArc(csr, *repaired, s, t, workspace);
+        return repaired;
+    });
+}
+
+/**
+ * Writes the frozen graph to a binary snapshot that readSnapshot can map back in without parsing.
+ * The snapshot records fingerprints of the CSV files so a later read can tell when it is stale.
+ * @param snapshot_path path of the snapshot file to write
+ * @param airport_path path to the Airport CSV file the graph was built from
+ * @param route_path path to the Route CSV file the graph was built from
+ */
+void Graph::writeSnapshot(string snapshot_path, string airport_path, string route_path) {
+    getCSR();
+
+    SnapshotWriter writer;
+    writer.value(verticeCount);
+    writer.value(edgeCount);
+    ids.save(writer);
+    airport_list.save(writer);
+    csr.save(writer);
+    landmarks.save(writer);
+    hierarchy.save(writer);
+    labels.save(writer);
+    writer.write(snapshot_path, SourceFingerprint::of(airport_path), SourceFingerprint::of(route_path));
+}
+
+/**
+ * Replaces this graph with the contents of a binary snapshot. The file is memory-mapped and its arrays are used in place.
+ * @param snapshot_path path of the snapshot file
+ * @param airport_path path to the Airport CSV file the snapshot must match
+ * @param route_path path to the Route CSV file the snapshot must match
+ * @return false, leaving the graph untouched, if the snapshot is missing, unreadable, from another version or stale
+ */
+bool Graph::readSnapshot(string snapshot_path, string airport_path, string route_path) {
+    try {
+        SnapshotReader reader(snapshot_path);
+        if (!reader.header().airports.matches(airport_path) || !reader.header().routes.matches(route_path)) return false;
+
+        Graph loaded;
+        loaded.verticeCount = reader.value<int>();
+        loaded.edgeCount = reader.value<int>();
+        loaded.ids.load(reader);
+        loaded.airport_list.load(reader);
+        loaded.csr.load(reader);
+        loaded.landmarks.load(reader);
+        loaded.hierarchy.load(reader);
+        loaded.labels.load(reader);
+        if (loaded.airport_list.size() != loaded.ids.size() || loaded.csr.vertexCount() != loaded.ids.size()) return false;
+        if (loaded.landmarks.count() > 0 && loaded.landmarks.vertexCount() != loaded.ids.size()) return false;
+        if (loaded.hierarchy.vertexCount() > 0 && loaded.hierarchy.vertexCount() != loaded.ids.size()) return false;
+        if (loaded.labels.vertexCount() > 0 && loaded.labels.vertexCount() != loaded.ids.size()) return false;
+        loaded.frozen = true;
+        loaded.buildCountryMasks();
+
+        *this = std::move(loaded);
+        return true;
+    } catch (std::exception& e) {
+        return false;
+    }
+}
+
+/**
+ * Returns the Compressed Sparse Row copy of the graph, rebuilding it first if edges were inserted since the last freeze
+ * @return the frozen graph, with rows indexed by dense airport index
+ */
+const CSRGraph& Graph::getCSR() {
+    if (!frozen) freeze();
+    return csr;
+}
+
+/**
+ * Rebuilds the unit-sphere airport positions used by A*, along with the largest factor the straight-line distance
+ * can be scaled by while staying at most the weight of every route. Weights are truncated to whole kilometers,
+ * so short routes weigh slightly less than the distance between their airports and the factor is a little below 1.
+ */
+void Graph::prepareSphere() {
+    const CSRGraph& graph = getCSR();
+    if (!sphereStale) return;
+
+    sphere = SpherePoints(airport_list);
+    sphereScale = 1.0;
+    for (int u = 0; u < graph.vertexCount(); u++) {
+        for (auto arc : graph.outgoing(u)) {
+            double straight = sphere.distance(u, arc.vertex);
+            if (straight > arc.weight) sphereScale = min(sphereScale, arc.weight / straight);
+        }
+    }
+    // Leave room for rounding in the distance computations so the heuristic never overestimates
+    sphereScale *= 1 - 1e-9;
+    sphereStale = false;
 }
 
 /**
@@ -42,92 +252,162 @@ Graph::Graph(string airport_path, string route_path) {
  * @param airport_path path to the Airport CSV file
  */
 void Graph::readAirportCSV(string airport_path) {
-    // Open airport file for reading
-    std::ifstream data(airport_path);
-    string line;
-
-    if (data.is_open()) {
-        // Get a line from the file and store it in line
-        while(getline(data, line)) {
-            
-            stringstream stream(line);
-            string line2;
-            auto temp = vector<string>();
-
-            // Parse the line by commas
-            while (getline(stream, line2, ',')) temp.push_back(line2);
-
-            // Populate airport list
-            airport_list[stoi(temp[0])] = Airport(temp[1], temp[2], temp[3], temp[4], temp[5], stod(temp[6]), stod(temp[7]), stoi(temp[0]));
-
-            // Initialize empty value in adjacency list for the current airport
-            adjacency_list[stoi(temp[0])] = pair<vector<Edge>, vector<Edge>>();
-            verticeCount++;
-        }
-    } else throw std::invalid_argument("Incorrect filepath");
+    // Map the airport file into memory and split each line in place; throws on an incorrect filepath
+    MappedFile data(airport_path);
+    CSVReader csv(data.begin(), data.end());
+
+    while (csv.next()) {
+        int code;
+        double latitude, longitude;
 
-    data.close();
+        // Makes sure no rogue data breaks the code
+        if (!parseInt(csv[0], code) || !parseDouble(csv[6], latitude) || !parseDouble(csv[7], longitude)) continue;
+
+        // Give the airport a dense index and a placeholder entry in the airport list
+        int index = addVertex(code);
+
+        // Populate airport list
+        airport_list.set(index, code, csv[1], csv[2], csv[3], csv[4], csv[5], latitude, longitude);
+        ids.setCodes(index, csv[4], csv[5]);
+        verticeCount++;
+    }
+    sphereStale = true;
+    buildCountryMasks();
 }
 
 /**
- * Reads from a CSV file containing a database of routes 
- * @param route_path path to the Route CSV file
- * @return a vector containing a vector of doubles where the first argument is the first airport's code, the second argument is the second airport's code, and the third argument is the distance between the two airports
+ * Rebuilds the mask of every country's airports from the airport list
  */
-vector<vector<double>> Graph::readRouteCSV(string route_path) {
-    // Open route file for reading
-    ifstream data(route_path);
-    string line;
-
-    auto toRet = vector<vector<double>>();
+void Graph::buildCountryMasks() {
+    countryMasks.clear();
+    for (int v = 0; v < airport_list.size(); v++) {
+        string_view country = airport_list.country(v);
+        if (country.empty()) continue;
+        auto it = countryMasks.try_emplace(string(country), airport_list.size()).first;
+        it->second.exclude(v);
+    }
+}
 
-    if (data.is_open()) {
-        // Get a line from the file and store it in line
-        while(getline(data, line)) {
-            stringstream stream(line);
-            string line2;
+ExclusionMask Graph::airportMask(const vector<Vertex>& airports) const {
+    ExclusionMask mask(ids.size());
+    for (Vertex airport : airports) mask.exclude(indexOf(airport));
+    return mask;
+}
 
-            auto temp = vector<string>();
+const ExclusionMask& Graph::countryMask(const string& country) const {
+    static const ExclusionMask none;
+    auto it = countryMasks.find(country);
+    return it == countryMasks.end() ? none : it->second;
+}
 
-            // Parse the line by commas
-            while (getline(stream, line2, ',')) temp.push_back(line2);
+/**
+ * Parses the routes in one part of a route CSV file and passes each valid route to a callback.
+ * Only reads the graph, so several parts of a file can be parsed at once.
+ * @param begin first byte of the part, at the start of a line
+ * @param end one past the last byte of the part, at the end of a line
+ * @param visit called with the source airport's code, the destination airport's code, and the distance between the two airports
+ */
+void Graph::readRoutes(const char* begin, const char* end, const function<void(Vertex, Vertex, double)>& visit) const {
+    CSVReader csv(begin, end);
 
-            // Makes sure no rogue data breaks the code
-            if (temp[3] == "\\N" || temp[5] == "\\N") continue;  
+    while (csv.next()) {
+        int airport1, airport2;
 
-            auto row = vector<double>();
+        // Makes sure no rogue data breaks the code, such as \N in place of an airport code
+        if (!parseInt(csv[3], airport1) || !parseInt(csv[5], airport2)) continue;
 
-            // Store airport codes
-            auto airport1 = stod(temp[3]);
-            auto airport2 = stod(temp[5]);
+        // Find distance, or weight, between the two airports
+        // Taken from https://stackoverflow.com/questions/10198985/calculating-the-distance-between-2-latitudes-and-longitudes-that-are-saved-in-a
+        int i1 = indexOf(airport1), i2 = indexOf(airport2);
+        double lat1 = i1 == -1 ? 0 : airport_list.latitude(i1), lon1 = i1 == -1 ? 0 : airport_list.longitude(i1);
+        double lat2 = i2 == -1 ? 0 : airport_list.latitude(i2), lon2 = i2 == -1 ? 0 : airport_list.longitude(i2);
+        visit(airport1, airport2, distanceEarth(lat1, lon1, lat2, lon2));
+    }
+}
 
-            // Push back codes to current row
-            row.push_back(airport1);
-            row.push_back(airport2);
+/**
+ * Reads from a CSV file containing a database of routes 
+ * @param route_path path to the Route CSV file
+ * @return a vector containing a vector of doubles where the first argument is the first airport's code, the second argument is the second airport's code, and the third argument is the distance between the two airports
+ */
+vector<vector<double>> Graph::readRouteCSV(string route_path) {
+    // Map the route file into memory; throws on an incorrect filepath
+    MappedFile data(route_path);
 
-            // Find distance, or weight, between the two airports
-            // Taken from https://stackoverflow.com/questions/10198985/calculating-the-distance-between-2-latitudes-and-longitudes-that-are-saved-in-a
-            double dist = distanceEarth(airport_list[airport1].getLatitude(), airport_list[airport1].getLongitude(), airport_list[airport2].getLatitude(), airport_list[airport2].getLongitude());
+    auto toRet = vector<vector<double>>();
+    readRoutes(data.begin(), data.end(), [&](Vertex airport1, Vertex airport2, double dist) {
+        toRet.push_back(vector<double>{(double) airport1, (double) airport2, dist});
+    });
+    return toRet;
+}
 
-            // Push back distance to current row
-            row.push_back(dist);
+/**
+ * A parsed route waiting to be inserted as an edge
+ */
+struct ParsedRoute {
+    Vertex source;
+    Vertex target;
+    double distance;
+};
 
-            // Push back row to vector we will return
-            toRet.push_back(row);
-        }
-    } else throw invalid_argument("Incorrect filepath"); // Handle incorrect filepaths
+/**
+ * Reads from a CSV file containing a database of routes and inserts every route as an edge,
+ * without building an intermediate list of routes when reading on one thread.
+ * With more threads the file is cut into newline-aligned chunks that are parsed concurrently into
+ * per-thread buffers, then inserted chunk by chunk so the edges end up in the same order as a serial load.
+ * Chunks are cut at raw newlines, so route files must not contain quoted fields spanning lines.
+ * @param route_path path to the Route CSV file
+ * @param threads number of threads to parse with
+ */
+void Graph::loadRouteCSV(string route_path, unsigned threads) {
+    // Map the route file into memory; throws on an incorrect filepath
+    MappedFile data(route_path);
+    auto insert = [this](Vertex airport1, Vertex airport2, double dist) { insertEdge(airport1, airport2, dist); };
+
+    // Small files are not worth the thread start-up cost
+    const size_t minChunkBytes = 1 << 16;
+    threads = (unsigned) max<size_t>(1, min<size_t>(threads, data.size() / minChunkBytes));
+    if (threads == 1) {
+        readRoutes(data.begin(), data.end(), insert);
+        return;
+    }
 
-    data.close();
-    return toRet;
+    // Cut the file into one chunk per thread, moving each cut forward to just past a newline
+    vector<const char*> cuts{data.begin()};
+    for (unsigned i = 1; i < threads; i++) {
+        const char* cut = max(cuts.back(), data.begin() + data.size() * i / threads);
+        const char* newline = (const char*) memchr(cut, '\n', data.end() - cut);
+        cuts.push_back(newline ? newline + 1 : data.end());
+    }
+    cuts.push_back(data.end());
+
+    // Parse every chunk on its own thread into its own buffer
+    vector<vector<ParsedRoute>> parsed(threads);
+    vector<thread> workers;
+    for (unsigned i = 0; i < threads; i++) {
+        workers.emplace_back([&, i]() {
+            readRoutes(cuts[i], cuts[i + 1], [&](Vertex airport1, Vertex airport2, double dist) {
+                parsed[i].push_back(ParsedRoute{airport1, airport2, dist});
+            });
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    // Insert the chunks in file order
+    size_t total = 0;
+    for (auto& chunk : parsed) total += chunk.size();
+    pending_edges.reserve(pending_edges.size() + total);
+    for (auto& chunk : parsed)
+        for (auto& route : chunk) insertEdge(route.source, route.target, route.distance);
 }
 
 // This function converts decimal degrees to radians
-double Graph::deg2rad(double deg) {
+double Graph::deg2rad(double deg) const {
   return (deg * M_PI / 180);
 }
 
 //  This function converts radians to decimal degrees
-double Graph::rad2deg(double rad) {
+double Graph::rad2deg(double rad) const {
   return (rad * 180 / M_PI);
 }
 
@@ -140,7 +420,7 @@ double Graph::rad2deg(double rad) {
  * @param lon2d Longitude of the second point in degrees
  * @return The distance between the two points in kilometers
  */
-double Graph::distanceEarth(double lat1d, double lon1d, double lat2d, double lon2d) {
+double Graph::distanceEarth(double lat1d, double lon1d, double lat2d, double lon2d) const {
   double lat1r, lon1r, lat2r, lon2r, u, v;
   lat1r = deg2rad(lat1d);
   lon1r = deg2rad(lon1d);
@@ -151,6 +431,42 @@ double Graph::distanceEarth(double lat1d, double lon1d, double lat2d, double lon
   return 2.0 * earthRadiusKm * asin(sqrt(u * u + cos(lat1r) * cos(lat2r) * v * v));
 }
 
+/**
+ * Gives an airport code a dense index, growing the airport list when the code is new.
+ * Codes first seen in a route get a placeholder Airport with only the code set.
+ * @param vertex Airport code
+ * @return the dense index of the airport
+ */
+int Graph::addVertex(Vertex vertex) {
+    int index = ids.insert(vertex);
+    if (index == airport_list.size()) airport_list.add(vertex);
+    return index;
+}
+
+/**
+ * Looks up an airport by code without modifying the graph
+ * @param vertex Airport code
+ * @return the airport, or a default Airport if the code is unknown
+ */
+Airport Graph::getAirport(Vertex vertex) const {
+    int index = ids.toIndex(vertex);
+    return index == -1 ? Airport() : airport_list.get(index);
+}
+
+/**
+ * Looks up an airport the way a user would name it
+ * @param name OpenFlights airport number, IATA code or ICAO code in either case, such as "3830", "ORD" or "kord"
+ * @return the airport code, or -1 if no airport has that name
+ */
+Vertex Graph::findAirport(string_view name) const {
+    int code;
+    if (parseInt(name, code)) return vertexExists(code) ? code : -1;
+    string upper(name);
+    for (char& c : upper) c = (char) toupper((unsigned char) c);
+    int index = upper.size() == 3 ? ids.fromIATA(upper) : upper.size() == 4 ? ids.fromICAO(upper) : -1;
+    return index == -1 ? -1 : codeOf(index);
+}
+
 /**
  * Creates an edge between a source and target Vertex with distance as weight
  * @param source Source airport code
@@ -158,12 +474,11 @@ double Graph::distanceEarth(double lat1d, double lon1d, double lat2d, double lon
  * @param rating Rating of the weight, in this case distance between the airports
  */
 void Graph::insertEdge(Vertex source, Vertex target, double rating) {
+    int s = addVertex(source), t = addVertex(target);
 
-    // Insert the edge to the index of the source airport
-    adjacency_list[source].first.emplace_back(Edge(source, target, rating));
-
-    // Insert the edge to the index of the destination airport
-    adjacency_list[target].second.emplace_back(Edge(source, target, rating));
+    // Queue the edge between the indices of the two airports until the next freeze
+    pending_edges.emplace_back(Edge(s, t, rating));
+    frozen = false;
 
     // Increase the edge count
     edgeCount++;
@@ -174,7 +489,7 @@ void Graph::insertEdge(Vertex source, Vertex target, double rating) {
  * @param vertex The code of the Airport to check
  * @return true if present, else false
  */
-bool Graph::vertexExists(Vertex vertex) { return adjacency_list.count(vertex); }
+bool Graph::vertexExists(Vertex vertex) const { return ids.contains(vertex); }
 
 /**
  * Checks whether an edge exists between a source and target Vertex in the graph
@@ -183,13 +498,12 @@ bool Graph::vertexExists(Vertex vertex) { return adjacency_list.count(vertex); }
  * @return true if edge exists, else false
  */
 bool Graph::edgeExists(Vertex source, Vertex target) {
-    // Create a temporary edge between the source and target
-    auto e = Edge(source, target);
+    if (!vertexExists(source)) throw out_of_range("Source does not exist");
 
-    // Iterate through edges of the source in our adjacency list
-    for (auto& edge : adjacency_list.at(source).first) {
-        // Check if temp edge is equal to an edge we find in our list, if so return true
-        if (edge == e) return true;
+    // Scan the contiguous outgoing arcs of the source
+    int t = indexOf(target);
+    for (auto arc : getCSR().outgoing(indexOf(source))) {
+        if (arc.vertex == t) return true;
     }
 
     // If no edges are foumnd, return false
@@ -202,11 +516,13 @@ bool Graph::edgeExists(Vertex source, Vertex target) {
  * @return a vector of vertex's containing the codes of all airports for which there is an incoming edge to the passed vertex
  */
 vector<Vertex> Graph::getIncoming(Vertex vertex) {
+    if (!vertexExists(vertex)) throw out_of_range("Vertex does not exist");
+
     // Create an empty vector of vertexes to store incoming vertexes
     auto adjacent = vector<Vertex>();
 
-    // Iterate through incoming edges to vertex in adjacency list
-    for (auto& edge : adjacency_list.at(vertex).second) adjacent.push_back(edge.source); // Add all edges to our adjacent vertex
+    // Iterate through incoming edges to vertex
+    for (auto arc : getCSR().incoming(indexOf(vertex))) adjacent.push_back(codeOf(arc.vertex)); // Add all edges to our adjacent vertex
 
     return adjacent;
 }
@@ -217,11 +533,13 @@ vector<Vertex> Graph::getIncoming(Vertex vertex) {
  * @return a vector of vertex's containing the codes of all airports for which there is an outgoing edge to the passed vertex
  */
 vector<Vertex> Graph::getOutgoing(Vertex vertex) {
+    if (!vertexExists(vertex)) throw out_of_range("Vertex does not exist");
+
     // Create an empty vector of vertexes to store outgoing vertexes
     auto adjacent = vector<Vertex>();
 
-    // Iterate through outgoing edges to vertex in adjacency list
-    for (auto& edge : adjacency_list.at(vertex).first) adjacent.push_back(edge.target); // Add all edges to our adjacent vertex
+    // Iterate through outgoing edges to vertex
+    for (auto arc : getCSR().outgoing(indexOf(vertex))) adjacent.push_back(codeOf(arc.vertex)); // Add all edges to our adjacent vertex
 
     return adjacent;
 }
@@ -233,26 +551,27 @@ vector<Vertex> Graph::getOutgoing(Vertex vertex) {
  * @return double distance between the two vertex's
  */
 double Graph::getDistance(Vertex source, Vertex dest) {
-    // Creates a temp edge between the source and destination
-    auto e = Edge(source, dest);
+    if (!vertexExists(source)) throw out_of_range("Source does not exist");
 
-    // Iterate through connected edges of the source vertex in adjacency list
-    for (auto& edge : adjacency_list.at(source).first)
-        if (e == edge) return edge.getWeight(); // Return weight of edge if a match is found
+    // Scan the contiguous outgoing arcs of the source vertex
+    int d = indexOf(dest);
+    for (auto arc : getCSR().outgoing(indexOf(source)))
+        if (arc.vertex == d) return arc.weight; // Return weight of edge if a match is found
 
-    // If no match is found, return weight of temp edge
-    return e.getWeight();
+    // If no match is found, return the weight of an unweighted edge
+    return Edge(source, dest).getWeight();
 }
 
 /**
  * Print all the entries in the graph
  */
 void Graph::printGraph() {
-    for (auto entry : adjacency_list) {
-        for (auto f : entry.second.first) cout << f << endl;
+    const CSRGraph& graph = getCSR();
+    for (int v = 0; v < graph.vertexCount(); v++) {
+        for (auto arc : graph.outgoing(v)) cout << Edge(codeOf(v), codeOf(arc.vertex), arc.weight) << endl;
         cout << endl;
 
-        for (auto f : entry.second.second) cout << f << endl;
+        for (auto arc : graph.incoming(v)) cout << Edge(codeOf(arc.vertex), codeOf(v), arc.weight) << endl;
         cout << endl << endl;
     }
 
@@ -262,42 +581,49 @@ void Graph::printGraph() {
 /**
  * BFS traversal of the graph from a source vertex
  * @param source Source vertex
- * @return a vector of airports that are connected to the source airport
+ * @param avoid Airports the traversal must not pass through
+ * @return every airport reachable from the source airport without passing an excluded one, in breadth-first order;
+ *         empty if the source is excluded
  */
-vector<Airport> Graph::BFS(Vertex source) {
+vector<Airport> Graph::BFS(Vertex source, const ExclusionMask& avoid) {
+    getCSR();
+    return BFS(source, workspace, avoid);
+}
+
+vector<Airport> Graph::BFS(Vertex source, SearchWorkspace& workspace, const ExclusionMask& avoid) const {
     if (!vertexExists(source)) throw invalid_argument("Source does not exist"); // Check if source exists
+    if (!frozen) throw logic_error("Graph must be frozen before read-only queries");
     
-    // Initialize a queue of vertexes to iterate through
-	queue<Vertex> q;
+    // Traverse dense airport indices rather than codes
+    int start = indexOf(source);
+    if (avoid.excluded(start)) return vector<Airport>();
 
-    // Initialize a map from ints to bools to store the vertexes we have visited
-	unordered_map<int, bool> visited(false);
+    // Reuse the workspace's queue, and mark visited vertexes by giving them a distance
+    workspace.reset(ids.size());
+    vector<int>& q = workspace.queue();
 
     // Initialize a vector of Airports to store the route from the traversal
 	vector<Airport> route;
 
     // Visit source
-    visited[source] = true;
+    workspace.dist(start) = 0;
 
     // Add source to the queue
-	q.push(source);
+	q.push_back(start);
 
-	while (!q.empty()) {
-        // Add current vertex to the front of the queue
-		Vertex current = q.front();
+	for (size_t head = 0; head < q.size(); head++) {
+        // Take the vertex at the front of the queue
+		int current = q[head];
 
         // Add current airport to the route
-        route.push_back(airport_list[current]);
-
-        // Pop current vertex from the queue
-		q.pop();
+        route.push_back(airport_list.get(current));
         
-        // Iterate through vertexes of outgoing edges of the source vertex
-		for (auto& r : getOutgoing(source)) {
-            // If we haven't visited the vertex, then visit the vertex
-            if (!visited[r]) {
-                visited[r] = true;
-                q.push(r);
+        // Iterate through vertexes of outgoing edges of the current vertex
+		for (auto arc : csr.outgoing(current)) {
+            // If we haven't visited the vertex and it is not excluded, then visit the vertex
+            if (!workspace.touched(arc.vertex) && !avoid.excluded(arc.vertex)) {
+                workspace.dist(arc.vertex) = workspace.dist(current) + 1;
+                q.push_back(arc.vertex);
             }
 		}
 	}
@@ -431,12 +757,622 @@ map<Vertex, pair<int, Vertex>> Graph::dijkstra(Vertex source)
     return toReturn;
 }
 
+ShortestPathTree Graph::shortestPathTree(Vertex source) {
+    getCSR();
+    return buildTree(indexOf(source), workspace);
+}
+
+/**
+ * Heap-based Dijkstra from s over the whole graph
+ * @param s dense index of the source airport, or -1 for a tree that reaches nothing
+ * @param workspace scratch arrays for the search, only the heap is used
+ * @return the distance and parent of every airport
+ */
+ShortestPathTree Graph::buildTree(int s, SearchWorkspace& workspace) const {
+    ShortestPathTree tree;
+    tree.source = s;
+    tree.dist.assign(ids.size(), INT_MAX);
+    tree.parent.assign(ids.size(), -1);
+    if (tree.source == -1) return tree;
+
+    const CSRGraph& graph = csr;
+    workspace.reset(ids.size());
+    IndexedHeap<4>& heap = workspace.heap();
+    tree.dist[tree.source] = 0;
+    heap.push(tree.source, 0);
+
+    while (!heap.empty()) {
+        // Settle the closest unsettled airport; its distance is now final
+        int d = heap.topKey();
+        int current = heap.pop();
+
+        // Relax every outgoing route, lowering the neighbor's key in place when we find a shorter path
+        for (auto arc : graph.outgoing(current)) {
+            int newDistance = d + arc.weight;
+            if (newDistance < tree.dist[arc.vertex]) {
+                tree.dist[arc.vertex] = newDistance;
+                tree.parent[arc.vertex] = current;
+                heap.push(arc.vertex, newDistance);
+            }
+        }
+    }
+    return tree;
+}
+
+HopTree Graph::hopTree(Vertex source, ThreadPool* pool, const ExclusionMask& avoid) {
+    return breadthFirstTree(getCSR(), indexOf(source), pool, avoid);
+}
+
+ShortestPathResult Graph::shortestPath(Vertex source, Vertex destination, PathAlgorithm algorithm) {
+    prepare(algorithm);
+    return shortestPath(source, destination, algorithm, workspace);
+}
+
+ShortestPathResult Graph::shortestPath(Vertex source, Vertex destination, PathAlgorithm algorithm, SearchWorkspace& workspace) const {
+    return shortestPath(source, destination, algorithm, ExclusionMask(), workspace);
+}
+
+ShortestPathResult Graph::shortestPath(Vertex source, Vertex destination, PathAlgorithm algorithm, const ExclusionMask& avoid) {
+    prepare(algorithm);
+    return shortestPath(source, destination, algorithm, avoid, workspace);
+}
+
+ShortestPathResult Graph::shortestPath(Vertex source, Vertex destination, PathAlgorithm algorithm, const ExclusionMask& avoid, SearchWorkspace& workspace) const {
+    int s = indexOf(source), t = indexOf(destination);
+    if (s == -1 || t == -1 || avoid.excluded(s) || avoid.excluded(t)) return ShortestPathResult();
+    if (!prepared(algorithm)) throw logic_error("Graph must be frozen and prepared for the algorithm before read-only queries");
+    if (s == t) return pathResult(vector<int>{s}, 0);
+
+    // The searches are compiled with and without the mask test, so unrestricted queries pay nothing for it
+    bool masked = !avoid.empty();
+    ShortestPathResult result;
+    switch (algorithm) {
+        case PathAlgorithm::Dijkstra: return masked ? dijkstraSearch<true>(s, t, workspace, avoid) : dijkstraSearch<false>(s, t, workspace, avoid);
+        case PathAlgorithm::AStar: return masked ? astarSearch<true>(s, t, workspace, avoid) : astarSearch<false>(s, t, workspace, avoid);
+        case PathAlgorithm::ALT: return masked ? altSearch<true>(s, t, workspace, avoid) : altSearch<false>(s, t, workspace, avoid);
+        case PathAlgorithm::ContractionHierarchy: result = hierarchySearch(s, t, workspace); break;
+        case PathAlgorithm::HubLabels: result = hubLabelSearch(s, t); break;
+        case PathAlgorithm::CachedTree: result = cachedTreeSearch(s, t, workspace); break;
+        default: return masked ? bidirectionalSearch<true>(s, t, workspace, avoid) : bidirectionalSearch<false>(s, t, workspace, avoid);
+    }
+
+    // Closing airports only lengthens routes, so a shortest route over every airport that avoids them is still shortest
+    for (Vertex airport : result.path) {
+        if (!avoid.excluded(indexOf(airport))) continue;
+        ShortestPathResult detour = bidirectionalSearch<true>(s, t, workspace, avoid);
+        detour.settled += result.settled;
+        return detour;
+    }
+    return result;
+}
+
+vector<ShortestPathResult> Graph::shortestPaths(const vector<pair<Vertex, Vertex>>& queries, PathAlgorithm algorithm, ThreadPool& pool, const ExclusionMask& avoid) const {
+    // Fail once up front rather than once per query
+    if (!prepared(algorithm)) throw logic_error("Graph must be frozen and prepared for the algorithm before read-only queries");
+    vector<ShortestPathResult> results(queries.size());
+    vector<SearchWorkspace> workspaces(pool.size());
+    pool.parallelFor(queries.size(), [&](size_t begin, size_t end, unsigned worker) {
+        for (size_t i = begin; i < end; i++) results[i] = shortestPath(queries[i].first, queries[i].second, algorithm, avoid, workspaces[worker]);
+    });
+    return results;
+}
+
+ShortestPathResult Graph::shortestPathWithStops(Vertex source, Vertex destination, int maxStops, const ExclusionMask& avoid) {
+    getCSR();
+    return shortestPathWithStops(source, destination, maxStops, workspace, avoid);
+}
+
+ShortestPathResult Graph::shortestPathWithStops(Vertex source, Vertex destination, int maxStops, SearchWorkspace& workspace, const ExclusionMask& avoid) const {
+    if (maxStops < 0) throw invalid_argument("maxStops must not be negative");
+    int s = indexOf(source), t = indexOf(destination);
+    if (s == -1 || t == -1 || avoid.excluded(s) || avoid.excluded(t)) return ShortestPathResult();
+    if (!frozen) throw logic_error("Graph must be frozen before read-only queries");
+    if (s == t) return pathResult(vector<int>{s}, 0);
+
+    // A shortest route never repeats an airport, so it has fewer legs than there are airports
+    int vertexCount = (int) ids.size();
+    maxStops = min(maxStops, vertexCount - 1);
+
+    // Layer h holds distances of routes with exactly h legs that beat every route with fewer legs;
+    // workspace.dist() holds the best distance over every layer so far
+    const CSRGraph& graph = csr;
+    int legs = maxStops + 1;
+    workspace.reset(vertexCount);
+    workspace.resetLayers(2);
+    vector<int>* frontier = &workspace.queue();
+    vector<int>* next = &workspace.nextQueue();
+    workspace.dist(s) = 0;
+    workspace.layerDist(0, s) = 0;
+    frontier->push_back(s);
+
+    // Layers are added as the search reaches them, so a generous maxStops costs nothing once no airport improves
+    bool masked = !avoid.empty();
+    int settled = 0, h = 0;
+    for (; h + 1 < legs && !frontier->empty(); h++) {
+        workspace.resetLayers(h + 2);
+        next->clear();
+        for (int u : *frontier) {
+            settled++;
+            int d = workspace.layerDistOf(h, u);
+            for (auto arc : graph.outgoing(u)) {
+                if (masked && avoid.excluded(arc.vertex)) continue;
+                int newDistance = d + arc.weight;
+                // A route already no shorter than the best one to the destination cannot lead to a better one
+                if (newDistance >= workspace.distOf(t) || newDistance >= workspace.dist(arc.vertex)) continue;
+                workspace.dist(arc.vertex) = newDistance;
+                if (workspace.layerDistOf(h + 1, arc.vertex) == INT_MAX && arc.vertex != t) next->push_back(arc.vertex);
+                workspace.layerDist(h + 1, arc.vertex) = newDistance;
+                workspace.layerParent(h + 1, arc.vertex) = u;
+            }
+        }
+        swap(frontier, next);
+    }
+    legs = min(legs, h + 1);
+    workspace.resetLayers(legs + 1);
+
+    // The last leg has to land on the destination, so only its incoming routes matter
+    for (auto arc : graph.incoming(t)) {
+        int d = workspace.layerDistOf(legs - 1, arc.vertex);
+        if (d == INT_MAX || d + arc.weight >= workspace.distOf(t)) continue;
+        workspace.dist(t) = d + arc.weight;
+        workspace.layerDist(legs, t) = d + arc.weight;
+        workspace.layerParent(legs, t) = arc.vertex;
+    }
+    settled += (int) frontier->size();
+    if (workspace.distOf(t) == INT_MAX) return pathResult(vector<int>(), settled);
+
+    // Walk back through the layers, stepping down to the last layer each airport improved in
+    vector<int> path;
+    h = legs;
+    for (int v = t; v != s; h--) {
+        while (workspace.layerDistOf(h, v) == INT_MAX) h--;
+        path.push_back(v);
+        v = workspace.layerParent(h, v);
+    }
+    path.push_back(s);
+    reverse(path.begin(), path.end());
+    return pathResult(path, settled);
+}
+
+vector<ShortestPathResult> Graph::shortestPathsWithStops(const vector<pair<Vertex, Vertex>>& queries, int maxStops, ThreadPool& pool, const ExclusionMask& avoid) const {
+    if (maxStops < 0) throw invalid_argument("maxStops must not be negative");
+    if (!frozen) throw logic_error("Graph must be frozen before read-only queries");
+    vector<ShortestPathResult> results(queries.size());
+    vector<SearchWorkspace> workspaces(pool.size());
+    pool.parallelFor(queries.size(), [&](size_t begin, size_t end, unsigned worker) {
+        for (size_t i = begin; i < end; i++) results[i] = shortestPathWithStops(queries[i].first, queries[i].second, maxStops, workspaces[worker], avoid);
+    });
+    return results;
+}
+
+vector<ParetoRoute> Graph::paretoRoutes(Vertex source, Vertex destination, int maxLegs, const ExclusionMask& avoid) {
+    getCSR();
+    return paretoRoutes(source, destination, maxLegs, pareto, avoid);
+}
+
+vector<ParetoRoute> Graph::paretoRoutes(Vertex source, Vertex destination, int maxLegs, ParetoSearch& search, const ExclusionMask& avoid) const {
+    int s = indexOf(source), t = indexOf(destination);
+    if (s == -1 || t == -1) return vector<ParetoRoute>();
+    if (!frozen) throw logic_error("Graph must be frozen before read-only queries");
+    auto routes = search.run(csr, s, t, maxLegs, avoid);
+    for (auto& route : routes)
+        for (auto& v : route.path) v = codeOf(v);
+    return routes;
+}
+
+vector<ShortestPathResult> Graph::kShortestPaths(Vertex source, Vertex destination, int k, const ExclusionMask& avoid) {
+    getCSR();
+    return kShortestPaths(source, destination, k, workspace, avoid);
+}
+
+vector<ShortestPathResult> Graph::kShortestPaths(Vertex source, Vertex destination, int k, SearchWorkspace& workspace, const ExclusionMask& avoid) const {
+    vector<ShortestPathResult> results;
+    int s = indexOf(source), t = indexOf(destination);
+    if (s == -1 || t == -1) return results;
+    if (!frozen) throw logic_error("Graph must be frozen before read-only queries");
+    for (auto& ranked : ::kShortestPaths(csr, s, t, k, workspace, avoid)) results.push_back(pathResult(ranked.path, ranked.settled));
+    return results;
+}
+
+/**
+ * Freezes the graph and builds the structure the algorithm searches with if it is missing
+ * @param algorithm search engine to prepare for
+ */
+void Graph::prepare(PathAlgorithm algorithm) {
+    // Refreeze first, since inserted edges discard everything built below
+    getCSR();
+    switch (algorithm) {
+        case PathAlgorithm::AStar: prepareSphere(); break;
+        case PathAlgorithm::ALT: if (landmarks.count() == 0) prepareLandmarks(); break;
+        case PathAlgorithm::ContractionHierarchy: if (hierarchy.vertexCount() == 0) prepareContractionHierarchy(); break;
+        case PathAlgorithm::HubLabels: if (labels.vertexCount() == 0) prepareHubLabels(); break;
+        default: break;
+    }
+}
+
+/**
+ * @param algorithm search engine to check
+ * @return true if the graph is frozen and algorithm can search it without building anything
+ */
+bool Graph::prepared(PathAlgorithm algorithm) const {
+    if (!frozen) return false;
+    switch (algorithm) {
+        case PathAlgorithm::AStar: return !sphereStale;
+        case PathAlgorithm::ALT: return landmarks.count() > 0;
+        case PathAlgorithm::ContractionHierarchy: return hierarchy.vertexCount() > 0;
+        case PathAlgorithm::HubLabels: return labels.vertexCount() > 0;
+        default: return true;
+    }
+}
+
+/**
+ * Heap-based Dijkstra from s that stops as soon as t is settled
+ * @param s dense index of the source airport
+ * @param t dense index of the destination airport
+ * @param workspace scratch arrays for the search
+ * @param avoid airports the search must not pass through, only tested when Masked
+ * @return the shortest path from s to t
+ */
+template <bool Masked>
+ShortestPathResult Graph::dijkstraSearch(int s, int t, SearchWorkspace& workspace, const ExclusionMask& avoid) const {
+    const CSRGraph& graph = csr;
+    workspace.reset(ids.size());
+    IndexedHeap<4>& heap = workspace.heap();
+    workspace.dist(s) = 0;
+    heap.push(s, 0);
+
+    int settled = 0;
+    while (!heap.empty()) {
+        int d = heap.topKey();
+        int current = heap.pop();
+        settled++;
+        if (current == t) break;
+
+        for (auto arc : graph.outgoing(current)) {
+            if (Masked && avoid.excluded(arc.vertex)) continue;
+            int newDistance = d + arc.weight;
+            if (newDistance < workspace.dist(arc.vertex)) {
+                workspace.dist(arc.vertex) = newDistance;
+                workspace.parent(arc.vertex) = current;
+                heap.push(arc.vertex, newDistance);
+            }
+        }
+    }
+    if (workspace.distOf(t) == INT_MAX) return pathResult(vector<int>(), settled);
+
+    // Follow the parent array back from the destination
+    vector<int> path;
+    for (int v = t; v != -1; v = workspace.parent(v)) path.push_back(v);
+    reverse(path.begin(), path.end());
+    return pathResult(path, settled);
+}
+
+/**
+ * A* from s to t, ordering the search by distance so far plus a lower bound on the distance left.
+ * The bound must be consistent with the route weights, so every airport is settled at most once and the search
+ * stops as soon as t is settled.
+ * @param s dense index of the source airport
+ * @param t dense index of the destination airport
+ * @param bound returns a lower bound on the distance from a dense index to t, or INT_MAX if t cannot be reached from it
+ * @param workspace scratch arrays for the search
+ * @param avoid airports the search must not pass through, only tested when Masked
+ * @return the shortest path from s to t
+ */
+template <bool Masked, typename LowerBound>
+ShortestPathResult Graph::guidedSearch(int s, int t, LowerBound bound, SearchWorkspace& workspace, const ExclusionMask& avoid) const {
+    const CSRGraph& graph = csr;
+    workspace.reset(ids.size());
+    IndexedHeap<4>& heap = workspace.heap();
+    auto remaining = [&](int v) {
+        int& estimate = workspace.estimate(v);
+        if (estimate == -1) estimate = bound(v);
+        return estimate;
+    };
+    if (remaining(s) == INT_MAX) return pathResult(vector<int>(), 0);
+    workspace.dist(s) = 0;
+    heap.push(s, remaining(s));
+
+    int settled = 0;
+    while (!heap.empty()) {
+        int current = heap.pop();
+        settled++;
+        if (current == t) break;
+
+        int d = workspace.dist(current);
+        for (auto arc : graph.outgoing(current)) {
+            if (Masked && avoid.excluded(arc.vertex)) continue;
+            int newDistance = d + arc.weight;
+            // Skip airports the bound proves cannot reach t
+            if (newDistance < workspace.dist(arc.vertex) && remaining(arc.vertex) != INT_MAX) {
+                workspace.dist(arc.vertex) = newDistance;
+                workspace.parent(arc.vertex) = current;
+                heap.push(arc.vertex, newDistance + remaining(arc.vertex));
+            }
+        }
+    }
+    if (workspace.distOf(t) == INT_MAX) return pathResult(vector<int>(), settled);
+
+    vector<int> path;
+    for (int v = t; v != -1; v = workspace.parent(v)) path.push_back(v);
+    reverse(path.begin(), path.end());
+    return pathResult(path, settled);
+}
+
+/**
+ * A* from s to t, guided by the straight-line distance to t.
+ * The estimate is the great-circle distance scaled by sphereScale and rounded down, which is consistent with the
+ * truncated integer weights.
+ * @param s dense index of the source airport
+ * @param t dense index of the destination airport
+ * @param workspace scratch arrays for the search
+ * @param avoid airports the search must not pass through, only tested when Masked
+ * @return the shortest path from s to t
+ */
+template <bool Masked>
+ShortestPathResult Graph::astarSearch(int s, int t, SearchWorkspace& workspace, const ExclusionMask& avoid) const {
+    return guidedSearch<Masked>(s, t, [&](int v) { return (int) (sphereScale * sphere.distance(v, t)); }, workspace, avoid);
+}
+
+/**
+ * ALT search from s to t: A* guided by the largest landmark lower bound
+ * @param s dense index of the source airport
+ * @param t dense index of the destination airport
+ * @param workspace scratch arrays for the search
+ * @param avoid airports the search must not pass through, only tested when Masked
+ * @return the shortest path from s to t
+ */
+template <bool Masked>
+ShortestPathResult Graph::altSearch(int s, int t, SearchWorkspace& workspace, const ExclusionMask& avoid) const {
+    return guidedSearch<Masked>(s, t, [&](int v) { return landmarks.lowerBound(v, t); }, workspace, avoid);
+}
+
+/**
+ * Contraction Hierarchy search from s to t
+ * @param s dense index of the source airport
+ * @param t dense index of the destination airport
+ * @param workspace scratch arrays for the upward searches
+ * @return the shortest path from s to t
+ */
+ShortestPathResult Graph::hierarchySearch(int s, int t, SearchWorkspace& workspace) const {
+    int settled = 0;
+    vector<int> path = hierarchy.query(s, t, settled, workspace);
+    return pathResult(path, settled);
+}
+
+/**
+ * Path from s to t read off s's shortest path tree, taking the tree from the cache or building and caching it
+ * @param s dense index of the source airport
+ * @param t dense index of the destination airport
+ * @param workspace scratch arrays for building the tree on a miss
+ * @return the shortest path from s to t
+ */
+ShortestPathResult Graph::cachedTreeSearch(int s, int t, SearchWorkspace& workspace) const {
+    int settled = 0;
+    shared_ptr<const ShortestPathTree> tree = trees.find(s);
+    if (!tree) {
+        tree = trees.insert(make_shared<const ShortestPathTree>(buildTree(s, workspace)));
+        for (int d : tree->dist) settled += d != INT_MAX;
+    }
+    if (!tree->reached(t)) return pathResult(vector<int>(), settled);
+
+    vector<int> path;
+    for (int v = t; v != -1; v = tree->parent[v]) path.push_back(v);
+    reverse(path.begin(), path.end());
+    return pathResult(path, settled);
+}
+
+/**
+ * Contracts the graph into a Contraction Hierarchy on a pool with a worker per hardware thread. Inserting edges discards it.
+ */
+void Graph::prepareContractionHierarchy() {
+    ThreadPool pool;
+    prepareContractionHierarchy(pool);
+}
+
+/**
+ * Contracts the graph into a Contraction Hierarchy. Inserting edges discards it.
+ * @param pool pool to run the witness searches on
+ */
+void Graph::prepareContractionHierarchy(ThreadPool& pool) {
+    hierarchy = ContractionHierarchy(getCSR(), &pool);
+}
+
+/**
+ * Hub label path from s to t
+ * @param s dense index of the source airport
+ * @param t dense index of the destination airport
+ * @return the shortest path from s to t; nothing is settled since no search runs
+ */
+ShortestPathResult Graph::hubLabelSearch(int s, int t) const {
+    return pathResult(labels.path(csr, s, t), 0);
+}
+
+/**
+ * Builds hub labels, using the Contraction Hierarchy order with the most important airport first. Inserting edges discards them.
+ */
+void Graph::prepareHubLabels() {
+    const CSRGraph& graph = getCSR();
+    if (hierarchy.vertexCount() == 0) prepareContractionHierarchy();
+    vector<int> order(graph.vertexCount());
+    for (int v = 0; v < graph.vertexCount(); v++) order[graph.vertexCount() - 1 - hierarchy.rankOf(v)] = v;
+    labels = HubLabels(graph, order);
+}
+
+/**
+ * Finds the length of the shortest route between two airports by merging their hub labels, building the labels first if there are none
+ * @param source Source airport code
+ * @param destination Destination airport code
+ * @param avoid Airports the route must not pass through; the labels cover routes through every airport, so a
+ *        bidirectional search that skips the excluded ones answers instead
+ * @return the shortest distance, or INT_MAX if either airport is unknown or excluded or there is no route
+ */
+int Graph::shortestDistance(Vertex source, Vertex destination, const ExclusionMask& avoid) {
+    int s = indexOf(source), t = indexOf(destination);
+    if (s == -1 || t == -1 || avoid.excluded(s) || avoid.excluded(t)) return INT_MAX;
+    if (s == t) return 0;
+    getCSR();
+    if (!avoid.empty()) return bidirectionalSearch<true>(s, t, workspace, avoid).totalDistance;
+    if (labels.vertexCount() == 0) prepareHubLabels();
+    return labels.distance(s, t);
+}
+
+/**
+ * Computes the shortest distance from every source to every target, sharing the work between pairs through the
+ * Contraction Hierarchy (contracting the graph first if it has not been)
+ * @param sources Source airport codes
+ * @param targets Target airport codes
+ * @param avoid Airports no route may pass through; shortcuts may skip over excluded airports, so with any excluded
+ *        the hierarchy is not used and each row comes from one Dijkstra search that skips them instead
+ * @return a row-major sources.size() by targets.size() matrix, where entry [i * targets.size() + j] is the distance
+ *         from sources[i] to targets[j], or INT_MAX if either airport is unknown or excluded or there is no route
+ */
+vector<int> Graph::distanceMatrix(const vector<Vertex>& sources, const vector<Vertex>& targets, const ExclusionMask& avoid) {
+    const CSRGraph& graph = getCSR();
+    vector<int> s(sources.size()), t(targets.size());
+    for (size_t i = 0; i < sources.size(); i++) s[i] = avoid.excluded(indexOf(sources[i])) ? -1 : indexOf(sources[i]);
+    for (size_t j = 0; j < targets.size(); j++) t[j] = avoid.excluded(indexOf(targets[j])) ? -1 : indexOf(targets[j]);
+    if (avoid.empty()) {
+        if (hierarchy.vertexCount() == 0) prepareContractionHierarchy();
+        return hierarchy.distanceMatrix(s, t);
+    }
+
+    // Each search stops once it has settled every target, which leaves their distances final
+    vector<char> isTarget(graph.vertexCount(), 0);
+    int targetCount = 0;
+    for (int v : t) {
+        if (v == -1 || isTarget[v]) continue;
+        isTarget[v] = 1;
+        targetCount++;
+    }
+    vector<int> matrix(sources.size() * targets.size(), INT_MAX);
+    for (size_t row = 0; row < sources.size(); row++) {
+        if (s[row] == -1) continue;
+        workspace.reset(graph.vertexCount());
+        IndexedHeap<4>& heap = workspace.heap();
+        workspace.dist(s[row]) = 0;
+        heap.push(s[row], 0);
+        int remaining = targetCount;
+        while (!heap.empty() && remaining > 0) {
+            int d = heap.topKey();
+            int current = heap.pop();
+            remaining -= isTarget[current];
+            for (auto arc : graph.outgoing(current)) {
+                if (avoid.excluded(arc.vertex) || d + arc.weight >= workspace.dist(arc.vertex)) continue;
+                workspace.dist(arc.vertex) = d + arc.weight;
+                heap.push(arc.vertex, d + arc.weight);
+            }
+        }
+        for (size_t column = 0; column < targets.size(); column++)
+            if (t[column] != -1) matrix[row * targets.size() + column] = workspace.distOf(t[column]);
+    }
+    return matrix;
+}
+
+/**
+ * Picks landmarks and computes their distance arrays for ALT search. Inserting edges discards them.
+ * @param count number of landmarks
+ */
+void Graph::prepareLandmarks(int count) {
+    landmarks = Landmarks(getCSR(), count);
+}
+
+/**
+ * Bidirectional Dijkstra between s and t
+ * @param s dense index of the source airport
+ * @param t dense index of the destination airport
+ * @param workspace scratch arrays for the search
+ * @param avoid airports the search must not pass through, only tested when Masked
+ * @return the shortest path from s to t
+ */
+template <bool Masked>
+ShortestPathResult Graph::bidirectionalSearch(int s, int t, SearchWorkspace& workspace, const ExclusionMask& avoid) const {
+    // Forward search from the source over outgoing routes, backward search from the destination over incoming routes
+    const CSRGraph& graph = csr;
+    workspace.reset(ids.size());
+    IndexedHeap<4>& forward = workspace.heap();
+    IndexedHeap<4>& backward = workspace.reverseHeap();
+    auto dist = [&](bool isForward, int v) -> int& { return isForward ? workspace.dist(v) : workspace.backwardDist(v); };
+    auto parent = [&](bool isForward, int v) -> int& { return isForward ? workspace.parent(v) : workspace.backwardParent(v); };
+    dist(true, s) = 0;
+    dist(false, t) = 0;
+    forward.push(s, 0);
+    backward.push(t, 0);
+
+    // Length of the best path found so far and the airport where its two halves meet
+    long long best = LLONG_MAX;
+    int meet = -1;
+    int settled = 0;
+
+    while (!forward.empty() && !backward.empty()) {
+        // Any path not yet seen is at least as long as the two smallest tentative distances combined
+        if ((long long) forward.topKey() + backward.topKey() >= best) break;
+
+        // Advance whichever search has the closer frontier
+        bool isForward = forward.topKey() <= backward.topKey();
+        IndexedHeap<4>& heap = isForward ? forward : backward;
+
+        int d = heap.topKey();
+        int current = heap.pop();
+        settled++;
+
+        for (auto arc : isForward ? graph.outgoing(current) : graph.incoming(current)) {
+            if (Masked && avoid.excluded(arc.vertex)) continue;
+            int newDistance = d + arc.weight;
+            int& known = dist(isForward, arc.vertex);
+            if (newDistance < known) {
+                known = newDistance;
+                parent(isForward, arc.vertex) = current;
+                heap.push(arc.vertex, newDistance);
+            }
+            // The searches touch here, so this is a complete path from source to destination
+            int other = dist(!isForward, arc.vertex);
+            if (other != INT_MAX && (long long) known + other < best) {
+                best = (long long) known + other;
+                meet = arc.vertex;
+            }
+        }
+    }
+    if (meet == -1) return pathResult(vector<int>(), settled);
+
+    // Walk back from the meeting airport to the source, then forward to the destination
+    vector<int> path;
+    for (int v = meet; v != -1; v = parent(true, v)) path.push_back(v);
+    reverse(path.begin(), path.end());
+    for (int v = parent(false, meet); v != -1; v = parent(false, v)) path.push_back(v);
+    return pathResult(path, settled);
+}
+
+/**
+ * Turns a path of dense indices into a ShortestPathResult, taking each leg's length from the shortest route between its two airports
+ * @param path dense indices of the airports on the path, empty if there is no path
+ * @param settled number of airports the search settled
+ * @return the path as airport codes along with its leg and total distances
+ */
+ShortestPathResult Graph::pathResult(const vector<int>& path, int settled) const {
+    ShortestPathResult result;
+    result.settled = settled;
+    if (path.empty()) return result;
+
+    const CSRGraph& graph = csr;
+    result.totalDistance = 0;
+    result.path.push_back(codeOf(path[0]));
+    for (unsigned i = 1; i < path.size(); i++) {
+        int leg = INT_MAX;
+        for (auto arc : graph.outgoing(path[i - 1]))
+            if (arc.vertex == path[i]) leg = min(leg, arc.weight);
+        result.path.push_back(codeOf(path[i]));
+        result.legDistances.push_back(leg);
+        result.totalDistance += leg;
+    }
+    return result;
+}
+
 void Graph::printDijkstraMap(std::map<Vertex, pair<int, Vertex>> algo) {
     for (auto it = algo.begin(); it != algo.end(); it++) {
-        if (airport_list[it->first].getName() != "" && airport_list[(it->second).second].getName() != "") {
-            std::cout << "Deperature Airport : " << airport_list[it->first].getName();
+        if (getAirport(it->first).getName() != "" && getAirport((it->second).second).getName() != "") {
+            std::cout << "Deperature Airport : " << getAirport(it->first).getName();
             std::cout << " | Shortest Distance : " << (it->second).first;
-            std::cout << " | Previous Airport : " << airport_list[(it->second).second].getName() << std::endl;
+            std::cout << " | Previous Airport : " << getAirport((it->second).second).getName() << std::endl;
         }
     }
 }
@@ -446,17 +1382,22 @@ void Graph::printDijkstraMap(std::map<Vertex, pair<int, Vertex>> algo) {
  * 
  * @param source 
  * @param destination 
+ * @param algorithm search engine used to find the path
  */
-void Graph::printPath(Vertex source, Vertex destination) {
-    auto path = findPath(source, destination);
+void Graph::printPath(Vertex source, Vertex destination, PathAlgorithm algorithm) {
+    auto result = shortestPath(source, destination, algorithm);
+    if (!result.found()) {
+        cout << "No Route Exists" << endl;
+        return;
+    }
+    auto& path = result.path;
     for (unsigned i = 0; i < path.size(); i++) {
-        auto curr = airport_list[path[i]];
+        auto curr = getAirport(path[i]);
         if (i == 0) cout << "\nSource Airport Name: " << curr.getName() << " | Source Airport Code: " << curr.getCode() << endl;
         else {
-            auto prev = airport_list[path[i - 1]];
             if (i == path.size() - 1) cout << "\nDestination Airport Name: " << curr.getName() << " | Destination Airport Code: " << curr.getCode();
             else cout << "\nCurrent Airport Name: " << curr.getName() << " | Current Airport Code: " << curr.getCode();
-            cout << " | Distance from previous airport: " << distanceEarth(curr.getLatitude(), curr.getLongitude(), prev.getLatitude(), prev.getLongitude()) << "km" << endl;
+            cout << " | Distance from previous airport: " << result.legDistances[i - 1] << "km" << endl;
         } 
     }
 }
@@ -485,38 +1426,34 @@ vector<float> Graph::getXYCoord(float lat, float lng, double width, double heigh
 }
 
 /**
- * @brief Calls recursive helper function to populate path vector, returns a vector with elements being stops on a route from source to destination
+ * @brief Returns a vector with elements being stops on a route from source to destination
  * 
  * @param source 
  * @param destination 
+ * @param algorithm search engine used to find the path
  * @return vector<Vertex> 
  */
-vector<Vertex> Graph::findPath(Vertex source, Vertex destination) {
+vector<Vertex> Graph::findPath(Vertex source, Vertex destination, PathAlgorithm algorithm) {
     vector<Vertex> path;
-    findPath(source, destination, path);
+    findPath(source, destination, path, algorithm);
     return path;
 }
 
 /**
- * @brief Recursively populate a vector with the shortest path from one airport to another using djikstra's algorithm
+ * @brief Appends the shortest path from one airport to another to a vector, running a single search
  * 
  * @param source 
  * @param destination 
  * @param path 
+ * @param algorithm search engine used to find the path
  */
-void Graph::findPath(Vertex source, Vertex destination, vector<Vertex>& path) {
-    auto d = dijkstra(source);
-    if (d.find(destination) == d.end()) {
+void Graph::findPath(Vertex source, Vertex destination, vector<Vertex>& path, PathAlgorithm algorithm) {
+    auto result = shortestPath(source, destination, algorithm);
+    if (!result.found()) {
         cout << "No Route Exists" << endl;
         return;
     }
-    if (d[destination].second == source) {
-        if (!count(path.begin(), path.end(), source)) path.push_back(source);
-        if (!count(path.begin(), path.end(), destination))path.push_back(destination);
-        return;
-    }
-    findPath(source, d[destination].second, path);
-    findPath(d[destination].second, destination, path);
+    path.insert(path.end(), result.path.begin(), result.path.end());
 }
 
 /**
@@ -526,10 +1463,14 @@ void Graph::graphAirportVisualization() {
     cs225::PNG png;
     // Read from worldmap image which is WGS84 to be compatible with our projection code
     png.readFromFile("worldmap.png");
-    for (auto& a : airport_list) {
+    for (int a = 0; a < airport_list.size(); a++) {
+        // Skip placeholder airports that only appear in routes and have no location
+        if (airport_list.name(a).empty()) continue;
+
         // Derive corresponding pixel values from airport latitude and longitude coordinates using helper function
-        float x = getXYCoord(a.second.getLatitude(), a.second.getLongitude(), png.width(), png.height())[0];
-        float y = getXYCoord(a.second.getLatitude(), a.second.getLongitude(), png.width(), png.height())[1];
+        auto xy = getXYCoord(airport_list.latitude(a), airport_list.longitude(a), png.width(), png.height());
+        float x = xy[0];
+        float y = xy[1];
 
         // Change color of airport and surrounding 8 pixels to red for more visibility on map
         for (int i = -2; i <= 2; i++) {
@@ -572,8 +1513,8 @@ void Graph::graphAirportAndRouteVisualization(Vertex source, Vertex destination)
         Vertex end = path[i];
 
         // Get X and Y coordinates for the start and end airports respectively
-        auto vec1 = getXYCoord(airport_list[start].getLatitude(), airport_list[start].getLongitude(), png.width(), png.height());
-        auto vec2 = getXYCoord(airport_list[end].getLatitude(), airport_list[end].getLongitude(), png.width(), png.height());
+        auto vec1 = getXYCoord(getAirport(start).getLatitude(), getAirport(start).getLongitude(), png.width(), png.height());
+        auto vec2 = getXYCoord(getAirport(end).getLatitude(), getAirport(end).getLongitude(), png.width(), png.height());
         float x1 = vec1[0];
         float y1 = vec1[1];
         float x2 = vec2[0];
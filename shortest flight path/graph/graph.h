@@ -5,19 +5,69 @@
 #pragma once
 
 #include "edge.h"
+#include "airports.h"
+#include "bfs.h"
+#include "geo.h"
+#include "ch.h"
+#include "csr.h"
+#include "heap.h"
+#include "hublabels.h"
+#include "idmap.h"
+#include "ksp.h"
+#include "landmarks.h"
+#include "mask.h"
+#include "pareto.h"
+#include "repair.h"
+#include "sptree.h"
+#include "threadpool.h"
+#include "treecache.h"
+#include "workspace.h"
 #include "../cs225/PNG.h"
 
+#include <climits>
+#include <functional>
 #include <unordered_map>
 #include <vector>
 #include <stdlib.h>
 #include <map>
 #include <math.h>
+#include <thread>
 
 using namespace std;
 using cs225::PNG;
 using cs225::HSLAPixel;
 
 
+/**
+ * Search engines that findPath and printPath can answer a point-to-point query with
+ */
+enum class PathAlgorithm {
+    Dijkstra,       // full single-source tree from the source, see Graph::shortestPathTree
+    Bidirectional,  // forward search from the source and backward search from the destination that stop once they meet
+    AStar,          // search from the source guided by the straight-line distance to the destination
+    ALT,            // search from the source guided by distances to and from landmark airports, see Landmarks
+    ContractionHierarchy, // upward search from both ends of a precomputed hierarchy, see ContractionHierarchy
+    HubLabels,      // distance oracle from precomputed hub labels, walked one route at a time, see HubLabels
+    CachedTree      // parent walk in the source's full shortest path tree, kept in an LRU cache, see TreeCache
+};
+
+/**
+ * Result of a point-to-point shortest path query, see Graph::shortestPath.
+ * legDistances[i] is the length of the route from path[i] to path[i + 1], and settled is the number of airports
+ * the search settled to answer the query.
+ */
+struct ShortestPathResult {
+    vector<Vertex> path;
+    int totalDistance = INT_MAX;
+    vector<int> legDistances;
+    int settled = 0;
+
+    /**
+     * @return true if a route from the source to the destination exists
+     */
+    bool found() const { return !path.empty(); }
+};
+
 /**
  * A class to construct a Graph
  */
@@ -29,18 +79,52 @@ class Graph {
      */
     Graph();
     Graph(string airport_path, string route_path);
+    Graph(string airport_path, string route_path, string snapshot_path);
     
     /**
      * Member functions
      */
     bool edgeExists(Vertex source, Vertex target);
-    bool vertexExists(Vertex vertex);
+    bool vertexExists(Vertex vertex) const;
     void insertEdge(Vertex source, Vertex target, double weight);
+    void freeze();
     void readAirportCSV(string airport_path);
     vector<vector<double>> readRouteCSV(string route_path);
+    void loadRouteCSV(string route_path, unsigned threads = 1);
+    void writeSnapshot(string snapshot_path, string airport_path, string route_path);
+    bool readSnapshot(string snapshot_path, string airport_path, string route_path);
     double getDistance(Vertex source, Vertex dest);
     void printGraph();
-    vector<Airport> BFS(int source);
+    vector<Airport> BFS(int source, const ExclusionMask& avoid = ExclusionMask());
+    vector<Airport> BFS(int source, SearchWorkspace& workspace, const ExclusionMask& avoid = ExclusionMask()) const;
+
+    /*
+    Route updates on a built graph
+        @param source : airport code the route leaves from
+        @param target : airport code the route arrives at
+        @param weight : new weight of the route, in kilometers, truncated to whole kilometers like insertEdge's
+
+        Unlike insertEdge these change the edge arrays in place instead of queueing a rebuild, and repair the cached
+        shortest path trees instead of dropping them (see relaxArc and repairArc); only the part of each tree whose
+        distances can change is searched again.  Landmarks, the Contraction Hierarchy and hub labels are discarded.
+        addRoute throws invalid_argument for an unknown airport or a negative weight.  removeRoute removes every
+        route from source to target and setRouteWeight reweights every one; both return false if there was none.
+    */
+    void addRoute(Vertex source, Vertex target, double weight);
+    bool removeRoute(Vertex source, Vertex target);
+    bool setRouteWeight(Vertex source, Vertex target, double weight);
+
+    /*
+    Direction-optimizing breadth-first search
+        @param source : initial vertex, as an airport code
+        @param pool : threads to expand each level on, or nullptr to run on the calling thread
+        @param avoid : airports no route may pass through, none by default
+
+        Returns a HopTree, indexed by dense airport index, holding the fewest routes needed to reach every airport from
+        source and an airport one route closer on the way.  See breadthFirstTree for how each level is expanded.
+        Excluded airports are never reached, and nothing is if the source is excluded.
+    */
+    HopTree hopTree(Vertex source, ThreadPool* pool = nullptr, const ExclusionMask& avoid = ExclusionMask());
 
     /*
     Helper function for Dijkstra's Algorithm.
@@ -77,29 +161,246 @@ class Graph {
     */
     std::map<Vertex, pair<int, Vertex>> dijkstra(Vertex source);
 
+    /*
+    Heap-based Dijkstra's Algorithm
+        @param source : initial vertex, as an airport code
+
+        Returns a ShortestPathTree, indexed by dense airport index, holding the shortest distance and
+        previous airport of every airport reachable from source along outgoing routes.  Uses an indexed 4-ary heap with
+        decrease-key, so a query costs O(E log V) instead of the O(V^2) scans done by dijkstra().
+    */
+    ShortestPathTree shortestPathTree(Vertex source);
+
+    /*
+    Point-to-point shortest path
+        @param source : initial vertex, as an airport code
+        @param destination : final vertex, as an airport code
+        @param algorithm : search engine to answer the query with
+
+        Returns the airport codes on a shortest path from source to destination along with the length of every leg,
+        the total distance and the number of airports settled.  The path is empty if there is none.
+        PathAlgorithm::Dijkstra stops as soon as the destination is settled.  PathAlgorithm::Bidirectional alternates
+        between a forward search over outgoing routes and a backward search over incoming routes, always advancing the
+        one with the smaller tentative distance, and stops as soon as the two smallest tentative distances add up to at
+        least the best path seen where the searches touch.  PathAlgorithm::AStar orders the search by distance so far plus
+        the great-circle distance left, which never overestimates since every route weighs its great-circle distance.
+        PathAlgorithm::ALT does the same with the landmark lower bounds, picking landmarks first if none are prepared.
+        PathAlgorithm::ContractionHierarchy searches the hierarchy, contracting the graph first if it is not prepared.
+        PathAlgorithm::HubLabels follows the hub label distances without a search, so settled is always 0.
+        PathAlgorithm::CachedTree walks parents in the source's shortest path tree, building and caching the tree
+        first on a miss, so settled is 0 on a hit and the number of airports reached on a miss.
+    */
+    ShortestPathResult shortestPath(Vertex source, Vertex destination, PathAlgorithm algorithm = PathAlgorithm::Bidirectional);
+
+    /*
+    Read-only point-to-point shortest path
+        @param source : initial vertex, as an airport code
+        @param destination : final vertex, as an airport code
+        @param algorithm : search engine to answer the query with
+        @param workspace : scratch arrays for the search, owned by the calling thread
+
+        Same result as shortestPath() above, but never freezes the graph or builds anything, so any number of threads
+        can call it at once as long as each passes its own workspace and nothing modifies the graph meanwhile.
+        Throws logic_error if the graph has unfrozen edges or prepare(algorithm) has not been called.
+    */
+    ShortestPathResult shortestPath(Vertex source, Vertex destination, PathAlgorithm algorithm, SearchWorkspace& workspace) const;
+
+    /*
+    Point-to-point shortest path avoiding airports
+        @param source : initial vertex, as an airport code
+        @param destination : final vertex, as an airport code
+        @param algorithm : search engine to answer the query with
+        @param avoid : airports the route must not pass through, built with airportMask() and countryMask()
+        @param workspace : scratch arrays for the search, owned by the calling thread
+
+        Same result as shortestPath() above on the graph without the excluded airports; the path is empty if source or
+        destination is excluded.  Dijkstra, Bidirectional, AStar and ALT skip excluded airports as they relax routes;
+        their bounds stay valid since closing airports only lengthens routes.  ContractionHierarchy, HubLabels and
+        CachedTree were built over every airport, so their answer is kept only if it avoids the mask (it is then still
+        a shortest route) and a bidirectional search that skips excluded airports answers otherwise.
+        The non-const overload prepares the algorithm first; the const one is read-only like the const shortestPath().
+    */
+    ShortestPathResult shortestPath(Vertex source, Vertex destination, PathAlgorithm algorithm, const ExclusionMask& avoid);
+    ShortestPathResult shortestPath(Vertex source, Vertex destination, PathAlgorithm algorithm, const ExclusionMask& avoid, SearchWorkspace& workspace) const;
+
+    /*
+    Exclusion masks
+        @param airports : airport codes to exclude; unknown codes are ignored
+        @param country : country name as in the airport CSV, for example "United States"
+
+        airportMask returns a mask excluding the given airports.  countryMask returns the mask of every airport in
+        the country, built once when the airports are loaded, or an empty mask for an unknown country.  Masks combine
+        with |, so "avoid JFK, LGA and Russia" is airportMask({3797, 3697}) | countryMask("Russia").
+    */
+    ExclusionMask airportMask(const vector<Vertex>& airports) const;
+    const ExclusionMask& countryMask(const string& country) const;
+
+    /*
+    Batch of point-to-point shortest paths
+        @param queries : source and destination airport codes of every query
+        @param algorithm : search engine to answer the queries with
+        @param pool : threads to spread the queries over
+
+        @param avoid : airports every route must not pass through, none by default
+
+        Returns the result of every query, in the same order.  Each worker reuses one workspace for all of its queries.
+        Same requirements as the read-only shortestPath().
+    */
+    vector<ShortestPathResult> shortestPaths(const vector<pair<Vertex, Vertex>>& queries, PathAlgorithm algorithm, ThreadPool& pool, const ExclusionMask& avoid = ExclusionMask()) const;
+
+    /*
+    Hop-limited shortest path
+        @param source : initial vertex, as an airport code
+        @param destination : final vertex, as an airport code
+        @param maxStops : most connections allowed between source and destination, so at most maxStops + 1 legs
+        @param avoid : airports the route must not pass through, none by default
+
+        Returns the shortest route that makes at most maxStops connections, or an empty path if there is none.
+        Runs a layered Bellman-Ford search where layer h holds the airports whose shortest route of at most h legs
+        improved on h - 1 legs, so each layer only relaxes the routes out of the airports that changed in the last one.
+        The last layer only checks the routes into the destination, and routes already longer than the best one found
+        to the destination are dropped.  settled counts the airports expanded across all layers.  Routes into excluded
+        airports are never relaxed, and the path is empty if source or destination is excluded.
+        The non-const overload freezes the graph first; the const one is read-only like the const shortestPath().
+        Throws invalid_argument if maxStops is negative.
+    */
+    ShortestPathResult shortestPathWithStops(Vertex source, Vertex destination, int maxStops, const ExclusionMask& avoid = ExclusionMask());
+    ShortestPathResult shortestPathWithStops(Vertex source, Vertex destination, int maxStops, SearchWorkspace& workspace, const ExclusionMask& avoid = ExclusionMask()) const;
+
+    /*
+    Batch of hop-limited shortest paths, answered like shortestPaths()
+        @param queries : source and destination airport codes of every query
+        @param maxStops : most connections allowed in every query
+        @param pool : threads to spread the queries over
+        @param avoid : airports every route must not pass through, none by default
+    */
+    vector<ShortestPathResult> shortestPathsWithStops(const vector<pair<Vertex, Vertex>>& queries, int maxStops, ThreadPool& pool, const ExclusionMask& avoid = ExclusionMask()) const;
+
+    /*
+    Pareto-optimal routes trading distance against legs
+        @param source : initial vertex, as an airport code
+        @param destination : final vertex, as an airport code
+        @param maxLegs : most legs a route may have
+        @param avoid : airports no route may pass through, none by default
+
+        Returns every route for which no other route is both shorter and made of no more legs, as (legs, distance,
+        path of airport codes) by increasing legs, so the last one is the shortest route overall.  Empty if there is
+        no route.  See ParetoSearch for how the labels are kept.  The non-const overload freezes the graph first and
+        reuses one label arena; the const one is read-only and takes the caller's.
+    */
+    vector<ParetoRoute> paretoRoutes(Vertex source, Vertex destination, int maxLegs = INT_MAX, const ExclusionMask& avoid = ExclusionMask());
+    vector<ParetoRoute> paretoRoutes(Vertex source, Vertex destination, int maxLegs, ParetoSearch& search, const ExclusionMask& avoid = ExclusionMask()) const;
+
+    /*
+    Alternative itineraries
+        @param source : initial vertex, as an airport code
+        @param destination : final vertex, as an airport code
+        @param k : most routes to return
+        @param avoid : airports no route may pass through, none by default
+
+        Returns up to k routes from source to destination that never visit an airport twice, shortest first, each
+        with its leg and total distances.  settled counts the airports searched to find that route.  Uses Yen's
+        algorithm with spur searches guided by a reverse shortest path tree, see kShortestPaths in ksp.h.
+        The non-const overload freezes the graph first; the const one is read-only like the const shortestPath().
+    */
+    vector<ShortestPathResult> kShortestPaths(Vertex source, Vertex destination, int k, const ExclusionMask& avoid = ExclusionMask());
+    vector<ShortestPathResult> kShortestPaths(Vertex source, Vertex destination, int k, SearchWorkspace& workspace, const ExclusionMask& avoid = ExclusionMask()) const;
+
+    /*
+    Freezes the graph and builds whatever algorithm searches with (airport positions, landmarks, the Contraction
+    Hierarchy or hub labels) if it is missing, so the read-only queries can use it.
+    */
+    void prepare(PathAlgorithm algorithm);
+
+    void prepareLandmarks(int count = 16);
+    const Landmarks& getLandmarks() const { return landmarks; }
+    void prepareContractionHierarchy();
+    void prepareContractionHierarchy(ThreadPool& pool);
+    const ContractionHierarchy& getContractionHierarchy() const { return hierarchy; }
+    void prepareHubLabels();
+    const HubLabels& getHubLabels() const { return labels; }
+    TreeCache& getTreeCache() const { return trees; }
+    int shortestDistance(Vertex source, Vertex destination, const ExclusionMask& avoid = ExclusionMask());
+    vector<int> distanceMatrix(const vector<Vertex>& sources, const vector<Vertex>& targets, const ExclusionMask& avoid = ExclusionMask());
+
     void printDijkstraMap(std::map<Vertex, pair<int, Vertex>> algo);
     vector<float> getXYCoord(float lat, float lng, double width, double height);
-    vector<Vertex> findPath(Vertex source, Vertex destination);
-    void findPath(Vertex source, Vertex destination, vector<Vertex>& path);
+    vector<Vertex> findPath(Vertex source, Vertex destination, PathAlgorithm algorithm = PathAlgorithm::Bidirectional);
+    void findPath(Vertex source, Vertex destination, vector<Vertex>& path, PathAlgorithm algorithm = PathAlgorithm::Bidirectional);
     vector<int> print(unordered_map<int, int> dist, int n, unordered_map<int, int> parent, vector<Vertex> vertices, Vertex source, Vertex dest, vector<int> populate_path);
     vector<int> recursivePath(unordered_map<int, int> parent, Vertex j, vector<int> populate_path);
     void graphAirportVisualization();
     void graphAirportAndRouteVisualization(Vertex source, Vertex destination);
-    void printPath(Vertex source, Vertex destination);
+    void printPath(Vertex source, Vertex destination, PathAlgorithm algorithm = PathAlgorithm::Bidirectional);
     /**
      * Getters
      */
     vector<Vertex> getIncoming(Vertex vertex);
     vector<Vertex> getOutgoing(Vertex vertex);
+    const CSRGraph& getCSR();
+    const VertexIdMap& getIdMap() const { return ids; }
+    int indexOf(Vertex vertex) const { return ids.toIndex(vertex); }
+    Vertex codeOf(int index) const { return ids.toCode(index); }
+    Airport getAirport(Vertex vertex) const;
+    Vertex findAirport(string_view name) const;
     int getVerticeCount() { return verticeCount; }
     int getEdgeCount() { return edgeCount; }
 
     private:
     int verticeCount = 0, edgeCount = 0;
-    unordered_map<int, Airport> airport_list;
-    unordered_map<int, pair<vector<Edge>, vector<Edge>>> adjacency_list;
 
-    double distanceEarth(double lat1d, double lon1d, double lat2d, double lon2d);
-    double deg2rad(double deg);
-    double rad2deg(double rad);
+    // Airport codes are remapped to contiguous indices; airport_list and the edges are indexed by them
+    VertexIdMap ids;
+    AirportTable airport_list;
+
+    // Frozen edge arrays used by the traversals, plus edges inserted since the last freeze()
+    CSRGraph csr;
+    vector<Edge> pending_edges;
+    bool frozen = false;
+
+    // Airport positions for the A* heuristic, rebuilt after the airports or edges change
+    SpherePoints sphere;
+    double sphereScale = 1.0;
+    bool sphereStale = true;
+
+    // Landmark distances for ALT search, the Contraction Hierarchy and hub labels, all discarded whenever the edges change
+    Landmarks landmarks;
+    ContractionHierarchy hierarchy;
+    HubLabels labels;
+
+    // Every airport of each country, for avoiding a whole country's airspace; built when the airports are loaded
+    unordered_map<string, ExclusionMask> countryMasks;
+
+    // Shortest path trees of recent sources, shared by every thread; repaired by the route updates, dropped by freeze()
+    mutable TreeCache trees;
+
+    // Scratch arrays for the queries made through the non-const shortestPath() and paretoRoutes()
+    SearchWorkspace workspace;
+    ParetoSearch pareto;
+
+    int addVertex(Vertex vertex);
+    template <bool Masked>
+    ShortestPathResult dijkstraSearch(int s, int t, SearchWorkspace& workspace, const ExclusionMask& avoid) const;
+    template <bool Masked>
+    ShortestPathResult bidirectionalSearch(int s, int t, SearchWorkspace& workspace, const ExclusionMask& avoid) const;
+    template <bool Masked>
+    ShortestPathResult astarSearch(int s, int t, SearchWorkspace& workspace, const ExclusionMask& avoid) const;
+    template <bool Masked>
+    ShortestPathResult altSearch(int s, int t, SearchWorkspace& workspace, const ExclusionMask& avoid) const;
+    ShortestPathResult hierarchySearch(int s, int t, SearchWorkspace& workspace) const;
+    ShortestPathResult hubLabelSearch(int s, int t) const;
+    ShortestPathResult cachedTreeSearch(int s, int t, SearchWorkspace& workspace) const;
+    ShortestPathTree buildTree(int s, SearchWorkspace& workspace) const;
+    template <bool Masked, typename LowerBound>
+    ShortestPathResult guidedSearch(int s, int t, LowerBound bound, SearchWorkspace& workspace, const ExclusionMask& avoid) const;
+    void prepareSphere();
+    void buildCountryMasks();
+    void discardPreprocessing();
+    void routeChanged(int s, int t, int before, int after);
+    bool prepared(PathAlgorithm algorithm) const;
+    ShortestPathResult pathResult(const vector<int>& path, int settled) const;
+    void readRoutes(const char* begin, const char* end, const function<void(Vertex, Vertex, double)>& visit) const;
+    double distanceEarth(double lat1d, double lon1d, double lat2d, double lon2d) const;
+    double deg2rad(double deg) const;
+    double rad2deg(double rad) const;
 };
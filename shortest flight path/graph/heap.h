@@ -0,0 +1,152 @@
+/**
+ * @file heap.h
+ */
+
+#pragma once
+
+#include <vector>
+
+using std::vector;
+
+/**
+ * An indexed d-ary min-heap over integer items in [0, capacity) keyed by integer priorities.
+ * Each item's position in the heap is tracked so its key can be lowered in place (decrease-key),
+ * which lets Dijkstra keep at most one heap entry per vertex.
+ */
+template <int D = 4>
+class IndexedHeap {
+    public:
+
+    /**
+     * Default constructor, creates an empty heap with no capacity
+     */
+    IndexedHeap() { }
+
+    /**
+     * Creates an empty heap that can hold items in [0, capacity)
+     * @param capacity Number of distinct items the heap can track
+     */
+    IndexedHeap(int capacity) { resize(capacity); }
+
+    /**
+     * Grows or shrinks the range of items the heap can hold, emptying it
+     * @param capacity Number of distinct items the heap can track
+     */
+    void resize(int capacity) {
+        heap.clear();
+        pos.assign(capacity, -1);
+        key.assign(capacity, 0);
+    }
+
+    /**
+     * Removes every item from the heap in O(size)
+     */
+    void clear() {
+        for (int item : heap) pos[item] = -1;
+        heap.clear();
+    }
+
+    /**
+     * @return true if the heap holds no items
+     */
+    bool empty() const { return heap.empty(); }
+
+    /**
+     * @return the number of items in the heap
+     */
+    int size() const { return (int) heap.size(); }
+
+    /**
+     * @return the number of distinct items the heap can track
+     */
+    int capacity() const { return (int) pos.size(); }
+
+    /**
+     * @param item Item to check
+     * @return true if the item is currently in the heap
+     */
+    bool contains(int item) const { return pos[item] != -1; }
+
+    /**
+     * @return the item with the smallest key
+     */
+    int top() const { return heap[0]; }
+
+    /**
+     * @return the smallest key in the heap
+     */
+    int topKey() const { return key[heap[0]]; }
+
+    /**
+     * Inserts an item, or lowers its key if it is already present with a larger key
+     * @param item Item to insert
+     * @param k Key of the item
+     */
+    void push(int item, int k) {
+        if (contains(item)) {
+            if (k < key[item]) {
+                key[item] = k;
+                siftUp(pos[item]);
+            }
+            return;
+        }
+        key[item] = k;
+        pos[item] = (int) heap.size();
+        heap.push_back(item);
+        siftUp(pos[item]);
+    }
+
+    /**
+     * Removes and returns the item with the smallest key
+     * @return the removed item
+     */
+    int pop() {
+        int item = heap[0];
+        pos[item] = -1;
+        int last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) {
+            heap[0] = last;
+            pos[last] = 0;
+            siftDown(0);
+        }
+        return item;
+    }
+
+    private:
+    vector<int> heap;
+    vector<int> pos;
+    vector<int> key;
+
+    void siftUp(int i) {
+        int item = heap[i];
+        while (i > 0) {
+            int parent = (i - 1) / D;
+            if (key[heap[parent]] <= key[item]) break;
+            heap[i] = heap[parent];
+            pos[heap[i]] = i;
+            i = parent;
+        }
+        heap[i] = item;
+        pos[item] = i;
+    }
+
+    void siftDown(int i) {
+        int item = heap[i];
+        int n = (int) heap.size();
+        while (true) {
+            int first = i * D + 1;
+            if (first >= n) break;
+            int best = first;
+            int last = first + D < n ? first + D : n;
+            for (int c = first + 1; c < last; c++)
+                if (key[heap[c]] < key[heap[best]]) best = c;
+            if (key[heap[best]] >= key[item]) break;
+            heap[i] = heap[best];
+            pos[heap[i]] = i;
+            i = best;
+        }
+        heap[i] = item;
+        pos[item] = i;
+    }
+};
@@ -0,0 +1,134 @@
+#include "hublabels.h"
+#include "heap.h"
+#include "snapshot.h"
+
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+#include <utility>
+
+using std::pair;
+
+/**
+ * Flattens per-vertex labels into CSR columns
+ */
+static void flatten(const vector<vector<pair<int, int>>>& labels, Column<int>& offsets, Column<int>& hubs, Column<int>& dists) {
+    vector<int> o(1, 0), h, d;
+    for (auto& label : labels) {
+        for (auto& entry : label) {
+            h.push_back(entry.first);
+            d.push_back(entry.second);
+        }
+        o.push_back((int) h.size());
+    }
+    offsets = std::move(o);
+    hubs = std::move(h);
+    dists = std::move(d);
+}
+
+HubLabels::HubLabels(const CSRGraph& graph, const vector<int>& order) {
+    int n = graph.vertexCount();
+    // out[v] holds (hub, d(v, hub)) and in[v] holds (hub, d(hub, v)); hubs are appended in order, so labels stay sorted
+    vector<vector<pair<int, int>>> out(n), in(n);
+    vector<int> dist(n, INT_MAX), hubDist(n, INT_MAX), touched;
+    IndexedHeap<4> heap(n);
+
+    for (int position = 0; position < (int) order.size(); position++) {
+        int hub = order[position];
+        for (bool forward : {true, false}) {
+            // Spread the hub's own label so the labels built so far can answer d(hub, v) or d(v, hub) in one scan of v's label
+            const auto& own = forward ? out[hub] : in[hub];
+            auto& labels = forward ? in : out;
+            for (auto& entry : own) hubDist[entry.first] = entry.second;
+
+            dist[hub] = 0;
+            touched.push_back(hub);
+            heap.push(hub, 0);
+            while (!heap.empty()) {
+                int d = heap.topKey();
+                int current = heap.pop();
+
+                // Prune once an earlier hub already covers this distance
+                int known = INT_MAX;
+                for (auto& entry : labels[current])
+                    if (hubDist[entry.first] != INT_MAX) known = std::min(known, hubDist[entry.first] + entry.second);
+                if (known <= d) continue;
+                labels[current].push_back({position, d});
+
+                for (auto arc : forward ? graph.outgoing(current) : graph.incoming(current)) {
+                    if (d + arc.weight < dist[arc.vertex]) {
+                        if (dist[arc.vertex] == INT_MAX) touched.push_back(arc.vertex);
+                        dist[arc.vertex] = d + arc.weight;
+                        heap.push(arc.vertex, dist[arc.vertex]);
+                    }
+                }
+            }
+
+            for (int v : touched) dist[v] = INT_MAX;
+            touched.clear();
+            for (auto& entry : own) hubDist[entry.first] = INT_MAX;
+        }
+    }
+
+    flatten(out, outOffsets, outHubs, outDists);
+    flatten(in, inOffsets, inHubs, inDists);
+}
+
+int HubLabels::distance(int s, int t) const {
+    int i = outOffsets[s], iEnd = outOffsets[s + 1];
+    int j = inOffsets[t], jEnd = inOffsets[t + 1];
+    long long best = INT_MAX;
+    while (i < iEnd && j < jEnd) {
+        if (outHubs[i] < inHubs[j]) i++;
+        else if (outHubs[i] > inHubs[j]) j++;
+        else best = std::min(best, (long long) outDists[i++] + inDists[j++]);
+    }
+    return (int) best;
+}
+
+vector<int> HubLabels::path(const CSRGraph& graph, int s, int t) const {
+    int left = distance(s, t);
+    if (left == INT_MAX) return vector<int>();
+
+    vector<int> path{s};
+    for (int current = s; current != t; ) {
+        int next = -1;
+        for (auto arc : graph.outgoing(current)) {
+            // Zero weight routes could otherwise lead back to an airport already on the path
+            if (arc.weight > left || std::find(path.begin(), path.end(), arc.vertex) != path.end()) continue;
+            if (arc.vertex == t ? arc.weight == left : distance(arc.vertex, t) == left - arc.weight) {
+                next = arc.vertex;
+                left -= arc.weight;
+                break;
+            }
+        }
+        if (next == -1) throw std::logic_error("Hub labels disagree with the graph");
+        path.push_back(next);
+        current = next;
+    }
+    return path;
+}
+
+void HubLabels::save(SnapshotWriter& writer) const {
+    writer.column(outOffsets);
+    writer.column(outHubs);
+    writer.column(outDists);
+    writer.column(inOffsets);
+    writer.column(inHubs);
+    writer.column(inDists);
+}
+
+void HubLabels::load(SnapshotReader& reader) {
+    outOffsets = reader.column<int>();
+    outHubs = reader.column<int>();
+    outDists = reader.column<int>();
+    inOffsets = reader.column<int>();
+    inHubs = reader.column<int>();
+    inDists = reader.column<int>();
+
+    // Reject arrays that would let a query read outside of them
+    size_t n = outOffsets.size();
+    if (n == 0 || inOffsets.size() != n || outDists.size() != outHubs.size() || inDists.size() != inHubs.size()
+        || !validRows(outOffsets, outHubs, n - 1) || !validRows(inOffsets, inHubs, n - 1))
+        throw std::runtime_error("Snapshot label arrays are inconsistent");
+}
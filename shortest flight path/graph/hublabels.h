@@ -0,0 +1,83 @@
+/**
+ * @file hublabels.h
+ */
+
+#pragma once
+
+#include "column.h"
+#include "csr.h"
+
+#include <cstddef>
+#include <vector>
+
+using std::vector;
+
+class SnapshotWriter;
+class SnapshotReader;
+
+/**
+ * A 2-hop hub labeling: every vertex stores a short list of hubs it reaches (forward label) and of hubs that reach it
+ * (backward label), each with the exact distance, such that some shortest path between any two vertices passes through
+ * a hub in both the source's forward label and the destination's backward label. A distance query is then a merge of
+ * two sorted lists instead of a search.
+ * Labels are built by pruned Dijkstra searches from every vertex in order of importance, skipping vertices whose
+ * distance the labels built so far already answer.
+ */
+class HubLabels {
+    public:
+
+    /**
+     * Default constructor, holds no labels
+     */
+    HubLabels() : outOffsets(vector<int>(1, 0)), inOffsets(vector<int>(1, 0)) { }
+
+    /**
+     * Builds labels for every vertex of a graph
+     * @param graph Graph to label
+     * @param order Every vertex of the graph, most important first
+     */
+    HubLabels(const CSRGraph& graph, const vector<int>& order);
+
+    /**
+     * @return the number of vertices labeled
+     */
+    int vertexCount() const { return (int) outOffsets.size() - 1; }
+
+    /**
+     * @return the number of hub entries over all forward and backward labels
+     */
+    size_t entryCount() const { return outHubs.size() + inHubs.size(); }
+
+    /**
+     * @return the number of bytes the label arrays take
+     */
+    size_t bytes() const { return (outOffsets.size() + inOffsets.size() + 2 * entryCount()) * sizeof(int); }
+
+    /**
+     * @param s Dense index of the source
+     * @param t Dense index of the destination
+     * @return the shortest distance from s to t, INT_MAX if t cannot be reached
+     */
+    int distance(int s, int t) const;
+
+    /**
+     * Rebuilds a shortest path by repeatedly stepping to a neighbor that is exactly one route closer to t
+     * @param graph Graph the labels were built from
+     * @param s Dense index of the source
+     * @param t Dense index of the destination
+     * @return the dense indices on a shortest path from s to t, empty if there is none
+     */
+    vector<int> path(const CSRGraph& graph, int s, int t) const;
+
+    void save(SnapshotWriter& writer) const;
+    void load(SnapshotReader& reader);
+
+    private:
+    // Label entries of vertex v are at [offsets[v], offsets[v + 1]), sorted by hub; hubs are positions in the order
+    Column<int> outOffsets;
+    Column<int> outHubs;
+    Column<int> outDists;
+    Column<int> inOffsets;
+    Column<int> inHubs;
+    Column<int> inDists;
+};
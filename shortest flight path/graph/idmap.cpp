@@ -0,0 +1,92 @@
+#include "idmap.h"
+#include "snapshot.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+/**
+ * Packs a code of one to four characters into an integer that sorts like the code
+ * @param code IATA or ICAO code
+ * @param packed Set to the packed code on success
+ * @return false if the code is empty, too long or the null marker
+ */
+static bool pack(string_view code, uint64_t& packed) {
+    if (code.empty() || code.size() > 4 || code == "\\N") return false;
+    packed = 0;
+    for (int i = 0; i < 4; i++) packed = (packed << 8) | (i < (int) code.size() ? (unsigned char) code[i] : 0);
+    return true;
+}
+
+int VertexIdMap::insert(Vertex code) {
+    if (code < 0) throw std::invalid_argument("Airport code must be non-negative");
+    auto& codes = codeToIndex.edit();
+    if (code >= (int) codes.size()) codes.resize(code + 1, -1);
+    if (codes[code] == -1) {
+        codes[code] = size();
+        indexToCode.edit().push_back(code);
+    }
+    return codes[code];
+}
+
+void VertexIdMap::setCodes(int index, string_view IATA, string_view ICAO) {
+    uint64_t packed;
+    if (pack(IATA, packed)) {
+        IATAKeys.edit().push_back(packed << 32 | (uint32_t) index);
+        IATASorted = false;
+    }
+    if (pack(ICAO, packed)) {
+        ICAOKeys.edit().push_back(packed << 32 | (uint32_t) index);
+        ICAOSorted = false;
+    }
+}
+
+void VertexIdMap::finalize() {
+    if (!IATASorted) std::sort(IATAKeys.edit().begin(), IATAKeys.edit().end());
+    if (!ICAOSorted) std::sort(ICAOKeys.edit().begin(), ICAOKeys.edit().end());
+    IATASorted = ICAOSorted = true;
+}
+
+int VertexIdMap::lookup(const Column<uint64_t>& keys, bool sorted, string_view code) {
+    uint64_t packed;
+    if (!pack(code, packed)) return -1;
+
+    // When a code is shared, the most recently added airport wins
+    if (!sorted) {
+        for (size_t i = keys.size(); i-- > 0;)
+            if (keys[i] >> 32 == packed) return (int) (uint32_t) keys[i];
+        return -1;
+    }
+    auto it = std::upper_bound(keys.begin(), keys.end(), packed << 32 | 0xFFFFFFFFULL);
+    if (it == keys.begin() || *(it - 1) >> 32 != packed) return -1;
+    return (int) (uint32_t) *(it - 1);
+}
+
+void VertexIdMap::save(SnapshotWriter& writer) const {
+    writer.column(codeToIndex);
+    writer.column(indexToCode);
+    writer.column(IATAKeys);
+    writer.column(ICAOKeys);
+}
+
+void VertexIdMap::load(SnapshotReader& reader) {
+    codeToIndex = reader.column<int>();
+    indexToCode = reader.column<Vertex>();
+    IATAKeys = reader.column<uint64_t>();
+    ICAOKeys = reader.column<uint64_t>();
+    IATASorted = ICAOSorted = true;
+
+    // Reject tables that would let a lookup read outside the arrays or return the wrong airport
+    size_t indexed = 0;
+    for (int index : codeToIndex) {
+        if (index < -1 || index >= size()) throw std::runtime_error("Snapshot airport index table is inconsistent");
+        indexed += index != -1;
+    }
+    if (indexed != indexToCode.size()) throw std::runtime_error("Snapshot airport index table is inconsistent");
+    for (int index = 0; index < size(); index++)
+        if (indexToCode[index] < 0 || toIndex(indexToCode[index]) != index) throw std::runtime_error("Snapshot airport index table is inconsistent");
+    for (const Column<uint64_t>* keys : {&IATAKeys, &ICAOKeys}) {
+        if (!std::is_sorted(keys->begin(), keys->end())) throw std::runtime_error("Snapshot airport code table is not sorted");
+        for (uint64_t key : *keys)
+            if ((uint32_t) key >= (uint32_t) size()) throw std::runtime_error("Snapshot airport code table is inconsistent");
+    }
+}
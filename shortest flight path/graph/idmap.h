@@ -0,0 +1,98 @@
+/**
+ * @file idmap.h
+ */
+
+#pragma once
+
+#include "column.h"
+#include "edge.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+class SnapshotWriter;
+class SnapshotReader;
+
+/**
+ * Maps the sparse OpenFlights airport codes onto contiguous indices 0..size()-1 and back,
+ * so per-airport data can live in flat vectors instead of hash maps.
+ * Also resolves IATA and ICAO codes to indices.
+ */
+class VertexIdMap {
+    public:
+
+    /**
+     * Returns the index of an airport code, assigning the next free index if the code is new
+     * @param code OpenFlights airport code, must be non-negative
+     * @return the dense index of code
+     */
+    int insert(Vertex code);
+
+    /**
+     * Records the IATA and ICAO codes of an indexed airport. Empty and "\N" codes are ignored.
+     * @param index Dense index of the airport
+     * @param IATA Three letter IATA code
+     * @param ICAO Four letter ICAO code
+     */
+    void setCodes(int index, string_view IATA, string_view ICAO);
+
+    /**
+     * Sorts the IATA and ICAO tables so lookups become binary searches. Called when the graph is frozen.
+     */
+    void finalize();
+
+    /**
+     * @param code OpenFlights airport code
+     * @return the dense index of code, or -1 if it is unknown
+     */
+    int toIndex(Vertex code) const { return code >= 0 && code < (int) codeToIndex.size() ? codeToIndex[code] : -1; }
+
+    /**
+     * @param index Dense index in [0, size())
+     * @return the OpenFlights airport code stored at index
+     */
+    Vertex toCode(int index) const { return indexToCode[index]; }
+
+    /**
+     * @param code OpenFlights airport code
+     * @return true if code has an index
+     */
+    bool contains(Vertex code) const { return toIndex(code) != -1; }
+
+    /**
+     * @param IATA Three letter IATA code
+     * @return the dense index of the airport with that code, or -1 if it is unknown
+     */
+    int fromIATA(string_view IATA) const { return lookup(IATAKeys, IATASorted, IATA); }
+
+    /**
+     * @param ICAO Four letter ICAO code
+     * @return the dense index of the airport with that code, or -1 if it is unknown
+     */
+    int fromICAO(string_view ICAO) const { return lookup(ICAOKeys, ICAOSorted, ICAO); }
+
+    /**
+     * @return the number of indexed airports
+     */
+    int size() const { return (int) indexToCode.size(); }
+
+    void save(SnapshotWriter& writer) const;
+    void load(SnapshotReader& reader);
+
+    private:
+    Column<int> codeToIndex;
+    Column<Vertex> indexToCode;
+
+    // Each entry packs a code of up to four characters into the high 32 bits and an index into the low 32 bits
+    Column<uint64_t> IATAKeys;
+    Column<uint64_t> ICAOKeys;
+    bool IATASorted = true, ICAOSorted = true;
+
+    static int lookup(const Column<uint64_t>& keys, bool sorted, string_view code);
+};
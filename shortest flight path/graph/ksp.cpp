@@ -0,0 +1,125 @@
+#include "ksp.h"
+
+#include <algorithm>
+#include <climits>
+#include <set>
+#include <utility>
+
+using std::pair;
+
+namespace {
+
+/**
+ * @return the weight of the lightest arc from u to v, or INT_MAX if there is none
+ */
+int arcWeight(const CSRGraph& graph, int u, int v) {
+    int weight = INT_MAX;
+    for (auto arc : graph.outgoing(u))
+        if (arc.vertex == v) weight = std::min(weight, arc.weight);
+    return weight;
+}
+
+}
+
+vector<RankedPath> kShortestPaths(const CSRGraph& graph, int s, int t, int k, SearchWorkspace& workspace, const ExclusionMask& avoid) {
+    vector<RankedPath> found;
+    int n = graph.vertexCount();
+    if (k <= 0 || s < 0 || t < 0 || s >= n || t >= n || avoid.excluded(t)) return found;
+    bool masked = !avoid.empty();
+
+    // Reverse Dijkstra from t: the exact distance to t of every vertex and the next hop of a shortest path there
+    vector<int> toTarget(n, INT_MAX), nextHop(n, -1);
+    int settled = 0;
+    {
+        workspace.reset(n);
+        IndexedHeap<4>& heap = workspace.heap();
+        toTarget[t] = 0;
+        heap.push(t, 0);
+        while (!heap.empty()) {
+            int d = heap.topKey();
+            int current = heap.pop();
+            settled++;
+            for (auto arc : graph.incoming(current)) {
+                if (masked && avoid.excluded(arc.vertex)) continue;
+                if (d + arc.weight < toTarget[arc.vertex]) {
+                    toTarget[arc.vertex] = d + arc.weight;
+                    nextHop[arc.vertex] = current;
+                    heap.push(arc.vertex, d + arc.weight);
+                }
+            }
+        }
+    }
+    if (toTarget[s] == INT_MAX) return found;
+
+    RankedPath first;
+    for (int v = s; v != -1; v = nextHop[v]) first.path.push_back(v);
+    first.distance = toTarget[s];
+    first.settled = settled;
+    found.push_back(first);
+
+    // Vertices on the current root path are blocked; a vertex is blocked while its stamp equals the current one
+    vector<unsigned> blocked(n, 0);
+    unsigned stamp = 0;
+    std::set<pair<int, vector<int>>> candidates;
+
+    while ((int) found.size() < k) {
+        const vector<int> previous = found.back().path;
+        settled = 0;
+        int rootDistance = 0;
+        stamp++;
+        for (size_t i = 0; i + 1 < previous.size(); i++) {
+            int spur = previous[i];
+            if (i > 0) blocked[previous[i - 1]] = stamp;
+
+            // Arcs out of the spur taken by found paths that share this root
+            vector<int> taken;
+            for (auto& path : found)
+                if (path.path.size() > i + 1 && std::equal(previous.begin(), previous.begin() + i + 1, path.path.begin()))
+                    taken.push_back(path.path[i + 1]);
+
+            // A* from the spur to t, guided by the exact unblocked distance to t
+            workspace.reset(n);
+            IndexedHeap<4>& heap = workspace.heap();
+            workspace.dist(spur) = 0;
+            heap.push(spur, toTarget[spur]);
+            bool reached = false;
+            while (!heap.empty()) {
+                int current = heap.pop();
+                settled++;
+                if (current == t) {
+                    reached = true;
+                    break;
+                }
+                int d = workspace.dist(current);
+                for (auto arc : graph.outgoing(current)) {
+                    int v = arc.vertex;
+                    if (blocked[v] == stamp || toTarget[v] == INT_MAX) continue;
+                    if (current == spur && std::find(taken.begin(), taken.end(), v) != taken.end()) continue;
+                    if (d + arc.weight < workspace.dist(v)) {
+                        workspace.dist(v) = d + arc.weight;
+                        workspace.parent(v) = current;
+                        heap.push(v, d + arc.weight + toTarget[v]);
+                    }
+                }
+            }
+
+            if (reached) {
+                vector<int> path(previous.begin(), previous.begin() + i);
+                size_t rootLength = path.size();
+                for (int v = t; v != -1; v = workspace.parent(v)) path.push_back(v);
+                std::reverse(path.begin() + rootLength, path.end());
+                candidates.insert({rootDistance + workspace.distOf(t), path});
+            }
+            rootDistance += arcWeight(graph, previous[i], previous[i + 1]);
+        }
+
+        if (candidates.empty()) break;
+        RankedPath next;
+        next.distance = candidates.begin()->first;
+        next.path = candidates.begin()->second;
+        next.settled = settled;
+        candidates.erase(candidates.begin());
+        found.push_back(next);
+    }
+    return found;
+}
@@ -0,0 +1,41 @@
+/**
+ * @file ksp.h
+ */
+
+#pragma once
+
+#include "csr.h"
+#include "mask.h"
+#include "workspace.h"
+
+#include <vector>
+
+using std::vector;
+
+/**
+ * One of the k shortest loopless paths, as dense indices, along with its length and the number of vertices the
+ * searches settled between finding the previous path and this one
+ */
+struct RankedPath {
+    vector<int> path;
+    int distance = 0;
+    int settled = 0;
+};
+
+/**
+ * Yen's k shortest loopless paths from s to t, shortest first, ties broken by the order of their vertices.
+ * Every path after the first branches off one already found at a spur vertex: the part up to the spur is kept, the
+ * vertices on it and the arcs the found paths take out of the spur are blocked, and the rest comes from a search from
+ * the spur. One reverse Dijkstra from t up front gives the exact distance to t of every vertex, which guides each
+ * spur search as an A* heuristic that stays consistent when vertices and arcs are blocked, so spur searches mostly
+ * walk straight along a shortest remaining path. Parallel arcs count as one arc of their smallest weight.
+ * @param graph Graph to search
+ * @param s Dense index of the source
+ * @param t Dense index of the destination
+ * @param k Most paths to return
+ * @param workspace Scratch arrays for the spur searches
+ * @param avoid Vertices no path may pass through; the reverse Dijkstra skips them, which leaves them without a
+ *        distance to t, and spur searches never enter a vertex without one
+ * @return up to k paths, fewer if there are not that many loopless paths
+ */
+vector<RankedPath> kShortestPaths(const CSRGraph& graph, int s, int t, int k, SearchWorkspace& workspace, const ExclusionMask& avoid = ExclusionMask());
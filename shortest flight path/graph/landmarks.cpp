@@ -0,0 +1,110 @@
+#include "landmarks.h"
+#include "heap.h"
+#include "snapshot.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+/**
+ * Runs Dijkstra from one vertex over outgoing or incoming arcs
+ * @param graph Graph to search
+ * @param source Dense index to start from
+ * @param reverse If true, follows incoming arcs so the result is the distance from every vertex to source
+ * @return the distance of every vertex, INT_MAX if unreachable
+ */
+static vector<int> distancesFrom(const CSRGraph& graph, int source, bool reverse) {
+    vector<int> dist(graph.vertexCount(), INT_MAX);
+    IndexedHeap<4> heap(graph.vertexCount());
+    dist[source] = 0;
+    heap.push(source, 0);
+    while (!heap.empty()) {
+        int d = heap.topKey();
+        int current = heap.pop();
+        for (auto arc : reverse ? graph.incoming(current) : graph.outgoing(current)) {
+            if (d + arc.weight < dist[arc.vertex]) {
+                dist[arc.vertex] = d + arc.weight;
+                heap.push(arc.vertex, dist[arc.vertex]);
+            }
+        }
+    }
+    return dist;
+}
+
+Landmarks::Landmarks(const CSRGraph& graph, int count) {
+    int n = graph.vertexCount();
+    if (n == 0 || count <= 0) return;
+
+    // Start from the best connected airport so the landmarks land in the main component
+    int hub = 0;
+    for (int v = 1; v < n; v++)
+        if (graph.outgoing(v).size() > graph.outgoing(hub).size()) hub = v;
+
+    // closest[v] is the distance from the nearest landmark so far, or from the hub before the first is chosen
+    vector<int> closest = distancesFrom(graph, hub, false);
+    vector<int> chosen;
+    vector<vector<int>> fromLandmark;
+    while ((int) chosen.size() < count) {
+        int farthest = -1;
+        for (int v = 0; v < n; v++)
+            if (closest[v] != INT_MAX && closest[v] > 0 && (farthest == -1 || closest[v] > closest[farthest])) farthest = v;
+        if (farthest == -1) break;
+
+        chosen.push_back(farthest);
+        fromLandmark.push_back(distancesFrom(graph, farthest, false));
+        if (chosen.size() == 1) closest = fromLandmark.back();
+        else for (int v = 0; v < n; v++) closest[v] = std::min(closest[v], fromLandmark.back()[v]);
+    }
+
+    int k = (int) chosen.size();
+    vector<int> forwardDist((size_t) n * k), backwardDist((size_t) n * k);
+    for (int i = 0; i < k; i++) {
+        vector<int> toLandmark = distancesFrom(graph, chosen[i], true);
+        for (int v = 0; v < n; v++) {
+            forwardDist[(size_t) v * k + i] = fromLandmark[i][v];
+            backwardDist[(size_t) v * k + i] = toLandmark[v];
+        }
+    }
+    landmarks = std::move(chosen);
+    forward = std::move(forwardDist);
+    backward = std::move(backwardDist);
+}
+
+int Landmarks::lowerBound(int v, int t) const {
+    int k = count();
+    const int* fromV = forward.data() + (size_t) v * k;
+    const int* fromT = forward.data() + (size_t) t * k;
+    const int* toV = backward.data() + (size_t) v * k;
+    const int* toT = backward.data() + (size_t) t * k;
+
+    int bound = 0;
+    for (int i = 0; i < k; i++) {
+        // d(v, t) >= d(L, t) - d(L, v); if L reaches v but not t, then v cannot reach t either
+        if (fromT[i] != INT_MAX) {
+            if (fromV[i] != INT_MAX) bound = std::max(bound, fromT[i] - fromV[i]);
+        } else if (fromV[i] != INT_MAX) return INT_MAX;
+
+        // d(v, t) >= d(v, L) - d(t, L); if t reaches L but v does not, then v cannot reach t either
+        if (toT[i] != INT_MAX) {
+            if (toV[i] == INT_MAX) return INT_MAX;
+            bound = std::max(bound, toV[i] - toT[i]);
+        }
+    }
+    return bound;
+}
+
+void Landmarks::save(SnapshotWriter& writer) const {
+    writer.column(landmarks);
+    writer.column(forward);
+    writer.column(backward);
+}
+
+void Landmarks::load(SnapshotReader& reader) {
+    landmarks = reader.column<int>();
+    forward = reader.column<int>();
+    backward = reader.column<int>();
+    if (forward.size() != backward.size() || (count() == 0 ? !forward.empty() : forward.size() % count() != 0))
+        throw std::runtime_error("Snapshot landmark arrays are inconsistent");
+    // Graph::readSnapshot checks vertexCount() against the airport count, so this keeps every landmark an airport
+    for (int landmark : landmarks)
+        if (landmark < 0 || landmark >= vertexCount()) throw std::runtime_error("Snapshot landmark arrays are inconsistent");
+}
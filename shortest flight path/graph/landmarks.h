@@ -0,0 +1,72 @@
+/**
+ * @file landmarks.h
+ */
+
+#pragma once
+
+#include "column.h"
+#include "csr.h"
+
+#include <climits>
+#include <vector>
+
+using std::vector;
+
+class SnapshotWriter;
+class SnapshotReader;
+
+/**
+ * Shortest distances from and to a few landmark airports, used by ALT (A*, Landmarks, Triangle inequality) search.
+ * For any landmark L the triangle inequality gives d(v, t) >= d(L, t) - d(L, v) and d(v, t) >= d(v, L) - d(t, L),
+ * and the largest of these over every landmark is a lower bound on the distance left that A* can be guided by.
+ * Distances of vertex v are stored next to each other, at [v * count() .. (v + 1) * count()).
+ */
+class Landmarks {
+    public:
+
+    /**
+     * Default constructor, holds no landmarks
+     */
+    Landmarks() { }
+
+    /**
+     * Picks landmarks by farthest selection and computes their distance arrays.
+     * The first landmark is the airport farthest from the airport with the most routes, and every next one is
+     * the airport farthest from all landmarks chosen so far.
+     * @param graph Graph to pick landmarks in
+     * @param count Number of landmarks to pick; fewer are picked if the graph runs out of reachable airports
+     */
+    Landmarks(const CSRGraph& graph, int count);
+
+    /**
+     * @return the number of landmarks
+     */
+    int count() const { return (int) landmarks.size(); }
+
+    /**
+     * @param i Which landmark
+     * @return the dense index of the landmark
+     */
+    int landmark(int i) const { return landmarks[i]; }
+
+    /**
+     * @return the number of vertices the distance arrays cover
+     */
+    int vertexCount() const { return count() == 0 ? 0 : (int) forward.size() / count(); }
+
+    /**
+     * @param v Dense index of the vertex the search is at
+     * @param t Dense index of the destination
+     * @return a lower bound on the distance from v to t, or INT_MAX if the landmarks prove t cannot be reached from v
+     */
+    int lowerBound(int v, int t) const;
+
+    void save(SnapshotWriter& writer) const;
+    void load(SnapshotReader& reader);
+
+    private:
+    Column<int> landmarks;
+    // forward[v * count() + i] is d(landmark i, v) and backward[v * count() + i] is d(v, landmark i), INT_MAX if there is no path
+    Column<int> forward;
+    Column<int> backward;
+};
@@ -0,0 +1,92 @@
+/**
+ * @file mask.h
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+using std::vector;
+
+/**
+ * A set of dense vertex indices a search must not pass through, stored one bit per vertex. Masks are built outside the
+ * graph and handed to each query, so closing airports never copies or changes the edge arrays. Indices past the end
+ * of the bits read as allowed, so an empty mask excludes nothing whatever the size of the graph.
+ */
+class ExclusionMask {
+    public:
+
+    /**
+     * Default constructor, creates a mask that excludes nothing
+     */
+    ExclusionMask() { }
+
+    /**
+     * Creates a mask that excludes nothing, with room for the given number of vertices
+     * @param vertexCount Number of vertices
+     */
+    explicit ExclusionMask(int vertexCount) : words((vertexCount + 63) / 64, 0) { }
+
+    /**
+     * @param v Dense vertex index to exclude; -1 (an unknown airport) is ignored
+     */
+    void exclude(int v) {
+        if (v < 0) return;
+        if ((size_t) v / 64 >= words.size()) words.resize(v / 64 + 1, 0);
+        words[v / 64] |= uint64_t(1) << (v % 64);
+    }
+
+    /**
+     * @param v Dense vertex index to allow again
+     */
+    void allow(int v) {
+        if (v >= 0 && (size_t) v / 64 < words.size()) words[v / 64] &= ~(uint64_t(1) << (v % 64));
+    }
+
+    /**
+     * @param v Dense vertex index
+     * @return true if searches must not pass through v
+     */
+    bool excluded(int v) const {
+        size_t word = (size_t) v / 64;
+        return word < words.size() && (words[word] >> (v % 64)) & 1;
+    }
+
+    /**
+     * @return true if no vertex is excluded
+     */
+    bool empty() const {
+        for (uint64_t word : words)
+            if (word) return false;
+        return true;
+    }
+
+    /**
+     * @return the number of excluded vertices
+     */
+    int count() const {
+        int total = 0;
+        for (uint64_t word : words) total += __builtin_popcountll(word);
+        return total;
+    }
+
+    /**
+     * Excludes every vertex the other mask excludes as well
+     * @param other Mask to merge in
+     * @return this mask
+     */
+    ExclusionMask& operator|=(const ExclusionMask& other) {
+        if (other.words.size() > words.size()) words.resize(other.words.size(), 0);
+        for (size_t i = 0; i < other.words.size(); i++) words[i] |= other.words[i];
+        return *this;
+    }
+
+    ExclusionMask operator|(const ExclusionMask& other) const {
+        ExclusionMask merged = *this;
+        return merged |= other;
+    }
+
+    private:
+    vector<uint64_t> words;
+};
@@ -0,0 +1,113 @@
+#include "pareto.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+// Orders the heap so the shortest label comes out first, and the one with fewer legs among equally short ones
+struct Later {
+    template <typename Entry>
+    bool operator()(const Entry& a, const Entry& b) const {
+        return a.distance != b.distance ? a.distance > b.distance : a.legs > b.legs;
+    }
+};
+
+}
+
+int& ParetoSearch::bag(int v) {
+    if (stamp[v] != generation) {
+        stamp[v] = generation;
+        head[v] = -1;
+    }
+    return head[v];
+}
+
+/**
+ * @return true if v's bag holds a label with no more legs and no more distance
+ */
+bool ParetoSearch::dominated(int v, int legs, int distance) {
+    for (int l = bag(v); l != -1; l = arena[l].next)
+        if (arena[l].legs <= legs && arena[l].distance <= distance) return true;
+    return false;
+}
+
+/**
+ * Unlinks and kills every label in v's bag with at least as many legs and at least as much distance
+ */
+void ParetoSearch::evict(int v, int legs, int distance) {
+    for (int* link = &bag(v); *link != -1;) {
+        Label& label = arena[*link];
+        if (label.legs >= legs && label.distance >= distance) {
+            label.dead = true;
+            *link = label.next;
+        } else {
+            link = &label.next;
+        }
+    }
+}
+
+vector<ParetoRoute> ParetoSearch::run(const CSRGraph& graph, int s, int t, int maxLegs, const ExclusionMask& avoid) {
+    int n = graph.vertexCount();
+    if ((int) head.size() != n) {
+        head.assign(n, -1);
+        stamp.assign(n, 0);
+        generation = 0;
+    }
+    if (++generation == 0) {
+        std::fill(stamp.begin(), stamp.end(), 0);
+        generation = 1;
+    }
+    arena.clear();
+    heap.clear();
+    if (avoid.excluded(s) || avoid.excluded(t)) return vector<ParetoRoute>();
+    bool masked = !avoid.empty();
+
+    auto create = [&](int v, int legs, int distance, int parent) {
+        if (arena.size() >= limit) throw std::length_error("Pareto search needs more than " + std::to_string(limit) + " labels");
+        int id = (int) arena.size();
+        arena.push_back(Label{distance, legs, v, parent, bag(v), false});
+        bag(v) = id;
+        heap.push_back(Entry{distance, legs, id});
+        std::push_heap(heap.begin(), heap.end(), Later());
+    };
+    create(s, 0, 0, -1);
+
+    vector<int> settledAtTarget;
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), Later());
+        Entry top = heap.back();
+        heap.pop_back();
+        const Label label = arena[top.label];
+        if (label.dead) continue;
+
+        // Every label still to come is at least as long, so this one is Pareto-optimal
+        if (label.vertex == t) {
+            settledAtTarget.push_back(top.label);
+            continue;
+        }
+        if (label.legs >= maxLegs) continue;
+
+        for (auto arc : graph.outgoing(label.vertex)) {
+            if (masked && avoid.excluded(arc.vertex)) continue;
+            int legs = label.legs + 1, distance = label.distance + arc.weight;
+            // Extending a label only adds legs and distance, so one dominated by a route already at t is useless
+            if (dominated(t, legs, distance) || dominated(arc.vertex, legs, distance)) continue;
+            evict(arc.vertex, legs, distance);
+            create(arc.vertex, legs, distance, top.label);
+        }
+    }
+
+    // Settled by increasing distance means decreasing legs; hand them back the other way round
+    vector<ParetoRoute> routes;
+    for (auto it = settledAtTarget.rbegin(); it != settledAtTarget.rend(); ++it) {
+        ParetoRoute route;
+        route.legs = arena[*it].legs;
+        route.distance = arena[*it].distance;
+        for (int l = *it; l != -1; l = arena[l].parent) route.path.push_back(arena[l].vertex);
+        std::reverse(route.path.begin(), route.path.end());
+        routes.push_back(route);
+    }
+    return routes;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file pareto.h
+ */
+
+#pragma once
+
+#include "csr.h"
+#include "mask.h"
+
+#include <climits>
+#include <vector>
+
+using std::vector;
+
+/**
+ * One Pareto-optimal itinerary: no other route is both shorter and made of no more legs
+ */
+struct ParetoRoute {
+    int legs = 0;
+    int distance = 0;
+    vector<Vertex> path;
+};
+
+/**
+ * Multi-criteria label-setting search that finds every Pareto-optimal route between two vertices when trading
+ * total distance against the number of legs. Every vertex keeps a bag of labels (legs, distance) none of which
+ * dominates another; labels are settled in order of distance, fewest legs first on ties, so a label is final once
+ * it is popped. A new label is dropped if its vertex's bag or the destination's bag already holds one with no more
+ * legs and no more distance, and it evicts the labels in its bag that it dominates.
+ * Labels live in one arena that is reused across searches and never grows past the label limit, and bags are lists
+ * threaded through the arena, so a search allocates nothing once the arena has grown. One object per thread.
+ */
+class ParetoSearch {
+    public:
+
+    /**
+     * Creates a search with an empty label arena
+     * @param labelLimit Most labels one search may create before it gives up
+     */
+    explicit ParetoSearch(size_t labelLimit = 1 << 22) : limit(labelLimit) { }
+
+    /**
+     * Finds every Pareto-optimal route from s to t
+     * @param graph Graph to search
+     * @param s Dense index of the source
+     * @param t Dense index of the destination
+     * @param maxLegs Most legs a route may have
+     * @param avoid Vertices no route may pass through; no labels are created at them
+     * @return the routes, with dense indices on their paths, by increasing legs and decreasing distance;
+     *         empty if there is no route. Throws length_error if the search needs more labels than the limit.
+     */
+    vector<ParetoRoute> run(const CSRGraph& graph, int s, int t, int maxLegs = INT_MAX, const ExclusionMask& avoid = ExclusionMask());
+
+    /**
+     * @return the number of labels the last search created
+     */
+    size_t labelCount() const { return arena.size(); }
+
+    private:
+    struct Label {
+        int distance;
+        int legs;
+        int vertex;
+        int parent;
+        int next;   // next label in the same bag, or -1
+        bool dead;  // evicted by a dominating label before being settled
+    };
+
+    struct Entry {
+        int distance;
+        int legs;
+        int label;
+    };
+
+    size_t limit;
+    vector<Label> arena;
+    vector<Entry> heap;
+
+    // Head of every vertex's bag, valid only where the stamp matches the current search
+    vector<int> head;
+    vector<unsigned> stamp;
+    unsigned generation = 0;
+
+    int& bag(int v);
+    bool dominated(int v, int legs, int distance);
+    void evict(int v, int legs, int distance);
+};
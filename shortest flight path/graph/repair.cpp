@@ -0,0 +1,87 @@
+#include "repair.h"
+
+int relaxArc(const CSRGraph& graph, ShortestPathTree& tree, int u, int v, int weight, SearchWorkspace& workspace) {
+    if (tree.dist[u] == INT_MAX || tree.dist[u] + weight >= tree.dist[v]) return 0;
+
+    workspace.reset(graph.vertexCount());
+    IndexedHeap<4>& heap = workspace.heap();
+    tree.dist[v] = tree.dist[u] + weight;
+    tree.parent[v] = u;
+    heap.push(v, tree.dist[v]);
+
+    // Only airports that just got closer enter the heap, so the search stops at the edge of the improved region
+    int changed = 0;
+    while (!heap.empty()) {
+        int d = heap.topKey();
+        int current = heap.pop();
+        changed++;
+        for (auto arc : graph.outgoing(current)) {
+            int newDistance = d + arc.weight;
+            if (newDistance < tree.dist[arc.vertex]) {
+                tree.dist[arc.vertex] = newDistance;
+                tree.parent[arc.vertex] = current;
+                heap.push(arc.vertex, newDistance);
+            }
+        }
+    }
+    return changed;
+}
+
+int repairArc(const CSRGraph& graph, ShortestPathTree& tree, int u, int v, SearchWorkspace& workspace) {
+    if (tree.parent[v] != u) return 0;
+
+    // A parallel arc of the old weight keeps v, and so the whole tree, where it was
+    int remaining = graph.weight(u, v);
+    if (remaining != INT_MAX && tree.dist[u] + remaining == tree.dist[v]) return 0;
+
+    // Collect the subtree below v; the children of an airport are the heads of its arcs that name it as parent.
+    // Touching an airport's stamp marks it as part of the subtree.
+    workspace.reset(graph.vertexCount());
+    vector<int>& subtree = workspace.queue();
+    subtree.clear();
+    subtree.push_back(v);
+    workspace.parent(v) = -1;
+    for (size_t i = 0; i < subtree.size(); i++) {
+        int current = subtree[i];
+        for (auto arc : graph.outgoing(current)) {
+            if (!workspace.touched(arc.vertex) && tree.parent[arc.vertex] == current) {
+                workspace.parent(arc.vertex) = -1;
+                subtree.push_back(arc.vertex);
+            }
+        }
+    }
+    for (int x : subtree) {
+        tree.dist[x] = INT_MAX;
+        tree.parent[x] = -1;
+    }
+
+    // Seed each airport with its best route in from outside the subtree, whose distances still hold
+    IndexedHeap<4>& heap = workspace.heap();
+    for (int x : subtree) {
+        for (auto arc : graph.incoming(x)) {
+            int from = arc.vertex;
+            if (workspace.touched(from) || tree.dist[from] == INT_MAX) continue;
+            if (tree.dist[from] + arc.weight < tree.dist[x]) {
+                tree.dist[x] = tree.dist[from] + arc.weight;
+                tree.parent[x] = from;
+            }
+        }
+        if (tree.dist[x] != INT_MAX) heap.push(x, tree.dist[x]);
+    }
+
+    // Settle the subtree; arcs leaving it cannot improve anything outside, since no distance there went down
+    while (!heap.empty()) {
+        int d = heap.topKey();
+        int current = heap.pop();
+        for (auto arc : graph.outgoing(current)) {
+            if (!workspace.touched(arc.vertex)) continue;
+            int newDistance = d + arc.weight;
+            if (newDistance < tree.dist[arc.vertex]) {
+                tree.dist[arc.vertex] = newDistance;
+                tree.parent[arc.vertex] = current;
+                heap.push(arc.vertex, newDistance);
+            }
+        }
+    }
+    return (int) subtree.size();
+}
@@ -0,0 +1,36 @@
+/**
+ * @file repair.h
+ */
+
+#pragma once
+
+#include "csr.h"
+#include "sptree.h"
+#include "workspace.h"
+
+/**
+ * Repairs a shortest path tree after the lightest arc from u to v got lighter or was added. Only airports whose
+ * distance drops are touched: the new arc is relaxed and Dijkstra runs outward from v while distances keep improving.
+ * @param graph Graph after the update
+ * @param tree Tree that was exact before the update; repaired in place
+ * @param u Source of the changed arc
+ * @param v Target of the changed arc
+ * @param weight Weight of the lightest arc from u to v after the update
+ * @param workspace Scratch arrays, only the heap is used
+ * @return the number of airports whose distance changed
+ */
+int relaxArc(const CSRGraph& graph, ShortestPathTree& tree, int u, int v, int weight, SearchWorkspace& workspace);
+
+/**
+ * Repairs a shortest path tree after the lightest arc from u to v got heavier or was removed, in the style of
+ * Ramalingam and Reps. If the tree reached v over that arc, every airport below v in the tree is reset, seeded with
+ * its best route in from an airport outside the subtree, and settled again by a Dijkstra confined to the subtree;
+ * the rest of the tree cannot have changed.
+ * @param graph Graph after the update
+ * @param tree Tree that was exact before the update; repaired in place
+ * @param u Source of the changed arc
+ * @param v Target of the changed arc
+ * @param workspace Scratch arrays; stamps mark the subtree and the heap orders it
+ * @return the number of airports recomputed, 0 if the tree did not use the arc
+ */
+int repairArc(const CSRGraph& graph, ShortestPathTree& tree, int u, int v, SearchWorkspace& workspace);
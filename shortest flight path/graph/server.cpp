@@ -0,0 +1,255 @@
+#include "server.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// Longest query line accepted; a connection that sends more without a newline is answered with an error and closed
+const size_t MAX_LINE = 4096;
+
+// Most bytes read from one connection per wakeup; the rest waits for the next wakeup so others get their turn
+const size_t MAX_READ = 1 << 16;
+
+// Most reply bytes queued for a connection before the server stops reading its queries until the client catches up
+const size_t MAX_BACKLOG = 1 << 20;
+
+}
+
+QueryServer::QueryServer(Graph& graph_, ThreadPool& pool_, PathAlgorithm algorithm_)
+    : graph(graph_), pool(pool_), algorithm(algorithm_), workspaces(pool_.size()) {
+    graph_.prepare(algorithm);
+    events = epoll_create1(EPOLL_CLOEXEC);
+    wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (events == -1 || wake == -1) throw std::runtime_error(string("Cannot create server event loop: ") + strerror(errno));
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = wake;
+    epoll_ctl(events, EPOLL_CTL_ADD, wake, &event);
+}
+
+QueryServer::~QueryServer() {
+    for (auto& connection : connections) ::close(connection.first);
+    if (listener != -1) {
+        ::close(listener);
+        unlink(socketPath.c_str());
+    }
+    if (wake != -1) ::close(wake);
+    if (events != -1) ::close(events);
+}
+
+void QueryServer::listen(const string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) throw std::runtime_error("Socket path is too long: " + path);
+    strcpy(address.sun_path, path.c_str());
+
+    listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listener == -1) throw std::runtime_error(string("Cannot create socket: ") + strerror(errno));
+    unlink(path.c_str());
+    if (bind(listener, (sockaddr*) &address, sizeof(address)) == -1 || ::listen(listener, SOMAXCONN) == -1) {
+        string reason = strerror(errno);
+        ::close(listener);
+        listener = -1;
+        throw std::runtime_error("Cannot listen on " + path + ": " + reason);
+    }
+    socketPath = path;
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listener;
+    epoll_ctl(events, EPOLL_CTL_ADD, listener, &event);
+}
+
+void QueryServer::stop() {
+    uint64_t one = 1;
+    ssize_t written = write(wake, &one, sizeof(one));
+    (void) written;
+}
+
+void QueryServer::run() {
+    vector<epoll_event> ready(64);
+    vector<Query> batch;
+    vector<int> touched;
+    while (true) {
+        int count = epoll_wait(events, ready.data(), (int) ready.size(), -1);
+        if (count == -1) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(string("Server event loop failed: ") + strerror(errno));
+        }
+
+        // Gather every complete line from this wakeup, then answer them together
+        batch.clear();
+        touched.clear();
+        bool stopping = false;
+        for (int i = 0; i < count; i++) {
+            int fd = ready[i].data.fd;
+            if (fd == wake) {
+                stopping = true;
+                continue;
+            }
+            if (fd == listener) {
+                accept();
+                continue;
+            }
+            auto it = connections.find(fd);
+            if (it == connections.end()) continue;
+            if (ready[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) receive(fd, it->second, batch);
+            touched.push_back(fd);
+        }
+
+        pool.parallelFor(batch.size(), [&](size_t begin, size_t end, unsigned worker) {
+            for (size_t i = begin; i < end; i++)
+                if (batch[i].reply.empty()) batch[i].reply = answer(graph, batch[i].line, algorithm, workspaces[worker]);
+        }, 1);
+        replies += batch.size();
+        for (auto& query : batch) connections[query.fd].output += query.reply;
+
+        // Write back what each connection is owed; one that hung up is closed once it has nothing left to send
+        for (int fd : touched) {
+            auto it = connections.find(fd);
+            if (it == connections.end()) continue;
+            flush(fd, it->second);
+        }
+        if (stopping) return;
+    }
+}
+
+/**
+ * Accepts every pending connection and watches it for queries
+ */
+void QueryServer::accept() {
+    while (true) {
+        int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == -1) return;
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(events, EPOLL_CTL_ADD, fd, &event);
+        connections[fd] = Connection();
+    }
+}
+
+/**
+ * Reads what a connection has sent, up to MAX_READ bytes, and moves its complete lines into the batch
+ * @param fd Connection socket
+ * @param connection Buffers of the connection
+ * @param batch Queries to answer in this wakeup
+ */
+void QueryServer::receive(int fd, Connection& connection, vector<Query>& batch) {
+    char buffer[16384];
+    size_t received = 0;
+    bool tooLong = false;
+    while (received < MAX_READ) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n > 0) {
+            connection.input.append(buffer, n);
+            received += n;
+            // Stop reading as soon as the unfinished line is too long, rather than buffering all the client sends
+            size_t partial = connection.input.size() - (connection.input.rfind('\n') + 1);
+            if (partial > MAX_LINE) {
+                tooLong = true;
+                break;
+            }
+            continue;
+        }
+        if (n == -1 && errno == EINTR) continue;
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) connection.closing = true;
+        break;
+    }
+
+    size_t start = 0, newline;
+    while ((newline = connection.input.find('\n', start)) != string::npos) {
+        size_t end = newline > start && connection.input[newline - 1] == '\r' ? newline - 1 : newline;
+        batch.push_back(Query{fd, connection.input.substr(start, end - start), string()});
+        start = newline + 1;
+    }
+    connection.input.erase(0, start);
+    if (tooLong) {
+        // Queued with its reply already set, so it goes out after the replies to the lines before it
+        connection.input.clear();
+        batch.push_back(Query{fd, string(), "ERROR query line is too long\n"});
+        connection.closing = true;
+    }
+}
+
+/**
+ * Sends as much queued output as the socket takes, waiting for EPOLLOUT if it fills up
+ * @param fd Connection socket
+ * @param connection Buffers of the connection
+ */
+void QueryServer::flush(int fd, Connection& connection) {
+    while (connection.sent < connection.output.size()) {
+        ssize_t n = send(fd, connection.output.data() + connection.sent, connection.output.size() - connection.sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            connection.sent += n;
+            continue;
+        }
+        if (n == -1 && errno == EINTR) continue;
+        if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // Only wait for room to write if the client hung up or is too far behind on reading its replies
+            bool backlogged = connection.output.size() - connection.sent > MAX_BACKLOG;
+            epoll_event event{};
+            event.events = connection.closing || backlogged ? EPOLLOUT : EPOLLIN | EPOLLOUT;
+            event.data.fd = fd;
+            epoll_ctl(events, EPOLL_CTL_MOD, fd, &event);
+            connection.writing = true;
+            return;
+        }
+        // The peer is gone, so nothing more can be delivered
+        close(fd);
+        return;
+    }
+
+    connection.output.clear();
+    connection.sent = 0;
+    if (connection.closing) {
+        close(fd);
+        return;
+    }
+    if (connection.writing) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(events, EPOLL_CTL_MOD, fd, &event);
+        connection.writing = false;
+    }
+}
+
+void QueryServer::close(int fd) {
+    epoll_ctl(events, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connections.erase(fd);
+}
+
+string QueryServer::answer(const Graph& graph, const string& line, PathAlgorithm algorithm, SearchWorkspace& workspace) {
+    // Split the line on whitespace into exactly two airport names
+    vector<string> names;
+    size_t i = 0;
+    while (i < line.size()) {
+        while (i < line.size() && isspace((unsigned char) line[i])) i++;
+        size_t start = i;
+        while (i < line.size() && !isspace((unsigned char) line[i])) i++;
+        if (i > start) names.push_back(line.substr(start, i - start));
+    }
+    if (names.size() != 2) return "ERROR expected \"<from> <to>\"\n";
+
+    Vertex source = graph.findAirport(names[0]), destination = graph.findAirport(names[1]);
+    if (source == -1) return "ERROR unknown airport " + names[0] + "\n";
+    if (destination == -1) return "ERROR unknown airport " + names[1] + "\n";
+
+    ShortestPathResult route = graph.shortestPath(source, destination, algorithm, workspace);
+    if (!route.found()) return "NONE\n";
+    string reply = "OK " + std::to_string(route.totalDistance);
+    for (Vertex airport : route.path) reply += " " + std::to_string(airport);
+    return reply + "\n";
+}
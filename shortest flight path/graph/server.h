@@ -0,0 +1,115 @@
+/**
+ * @file server.h
+ */
+
+#pragma once
+
+#include "graph.h"
+#include "threadpool.h"
+#include "workspace.h"
+
+#include <atomic>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+/**
+ * Answers shortest path queries from a graph loaded once, over a Unix domain socket.
+ *
+ * The protocol is one query per line, "<from> <to>\n", where each airport is an OpenFlights number or an IATA or
+ * ICAO code. Every query gets one reply line, in the order the connection sent them:
+ *     "OK <total km> <airport> <airport> ...\n"   airport numbers along a shortest route
+ *     "NONE\n"                                    no route exists
+ *     "ERROR <reason>\n"                          the line could not be answered
+ * A client may pipeline any number of queries before reading the replies.
+ *
+ * One thread runs an epoll loop over the listening socket and every connection with non-blocking reads and writes.
+ * All complete lines that arrive in one wakeup are answered as a single batch spread over the thread pool, each worker
+ * reusing its own search workspace, and the replies are queued back to their connections.
+ */
+class QueryServer {
+    public:
+
+    /**
+     * Prepares the graph for the algorithm so every query after this is read-only
+     * @param graph Graph to answer from; must outlive the server and not be modified while it runs
+     * @param pool Threads to answer each batch of queries on
+     * @param algorithm Search engine to answer with
+     */
+    QueryServer(Graph& graph, ThreadPool& pool, PathAlgorithm algorithm = PathAlgorithm::Bidirectional);
+
+    /**
+     * Closes every connection and the listening socket, and removes the socket file
+     */
+    ~QueryServer();
+
+    QueryServer(const QueryServer&) = delete;
+    QueryServer& operator=(const QueryServer&) = delete;
+
+    /**
+     * Binds and listens on a socket file, replacing a stale one left by an earlier server. Clients may connect as soon
+     * as this returns, even before run() starts. Throws runtime_error if the socket cannot be set up.
+     * @param path Path of the socket file
+     */
+    void listen(const string& path);
+
+    /**
+     * Runs the event loop on the calling thread until stop() is called
+     */
+    void run();
+
+    /**
+     * Makes run() return after its current batch. Safe to call from any thread, or a signal handler.
+     */
+    void stop();
+
+    /**
+     * @return the number of queries answered so far
+     */
+    size_t answered() const { return replies.load(); }
+
+    /**
+     * Answers one query line
+     * @param graph Graph prepared for algorithm
+     * @param line Query without its newline
+     * @param algorithm Search engine to answer with
+     * @param workspace Scratch arrays owned by the calling thread
+     * @return the reply line, with its newline
+     */
+    static string answer(const Graph& graph, const string& line, PathAlgorithm algorithm, SearchWorkspace& workspace);
+
+    private:
+    struct Connection {
+        string input;
+        string output;
+        size_t sent = 0;
+        bool writing = false;
+        bool closing = false;
+    };
+
+    struct Query {
+        int fd;
+        string line;
+        string reply;
+    };
+
+    const Graph& graph;
+    ThreadPool& pool;
+    PathAlgorithm algorithm;
+    vector<SearchWorkspace> workspaces;
+
+    string socketPath;
+    int listener = -1;
+    int events = -1;
+    int wake = -1;
+    std::atomic<size_t> replies{0};
+    std::unordered_map<int, Connection> connections;
+
+    void accept();
+    void receive(int fd, Connection& connection, vector<Query>& batch);
+    void flush(int fd, Connection& connection);
+    void close(int fd);
+};
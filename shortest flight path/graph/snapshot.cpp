@@ -0,0 +1,116 @@
+#include "snapshot.h"
+
+#include <fstream>
+
+#include <sys/stat.h>
+
+static const char MAGIC[8] = {'S', 'F', 'P', 'G', 'R', 'A', 'P', 'H'};
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+/**
+ * Hashes a buffer eight bytes at a time
+ * @param data First byte
+ * @param size Number of bytes
+ * @return 64-bit hash of the bytes
+ */
+static uint64_t hashBytes(const char* data, size_t size) {
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ size;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        h = (h ^ word) * 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 32;
+    }
+    for (; i < size; i++) h = (h ^ (unsigned char) data[i]) * 0x100000001B3ULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    return h ^ (h >> 33);
+}
+
+/**
+ * @param info Result of stat
+ * @return the modification time in nanoseconds
+ */
+static int64_t modifiedTime(const struct stat& info) {
+    return (int64_t) info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+}
+
+SourceFingerprint SourceFingerprint::of(const string& path) {
+    SourceFingerprint fingerprint;
+    struct stat info;
+    if (stat(path.c_str(), &info) == -1) return fingerprint;
+    fingerprint.size = (uint64_t) info.st_size;
+    fingerprint.modified = modifiedTime(info);
+    MappedFile file(path);
+    fingerprint.hash = hashBytes(file.begin(), file.size());
+    return fingerprint;
+}
+
+bool SourceFingerprint::matches(const string& path) const {
+    struct stat info;
+    if (stat(path.c_str(), &info) == -1 || (uint64_t) info.st_size != size) return false;
+    if (modifiedTime(info) == modified) return true;
+
+    // The file was touched or copied; it is only stale if its contents changed
+    MappedFile file(path);
+    return hashBytes(file.begin(), file.size()) == hash;
+}
+
+void SnapshotWriter::write(const string& path, const SourceFingerprint& airports, const SourceFingerprint& routes) const {
+    SnapshotHeader header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = SnapshotReader::VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.sectionCount = (uint32_t) sections.size();
+    header.reserved = 0;
+    header.airports = airports;
+    header.routes = routes;
+
+    // Lay the sections out after the table, each starting on an 8 byte boundary so mapped columns are aligned
+    vector<SnapshotSection> table(sections.size());
+    uint64_t offset = sizeof(SnapshotHeader) + sections.size() * sizeof(SnapshotSection);
+    for (size_t i = 0; i < sections.size(); i++) {
+        offset = (offset + 7) & ~7ULL;
+        table[i] = SnapshotSection{offset, sections[i].bytes, sections[i].elementSize};
+        offset += sections[i].bytes;
+    }
+
+    // Write to a temporary file and rename it, so readers never map a half written snapshot
+    string temporary = path + ".tmp";
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) throw std::invalid_argument("Incorrect filepath");
+
+    out.write((const char*) &header, sizeof(header));
+    out.write((const char*) table.data(), table.size() * sizeof(SnapshotSection));
+    uint64_t written = sizeof(SnapshotHeader) + table.size() * sizeof(SnapshotSection);
+    const char padding[8] = {0};
+    for (size_t i = 0; i < sections.size(); i++) {
+        out.write(padding, table[i].offset - written);
+        const char* data = sections[i].data ? sections[i].data : (const char*) &sections[i].inlineValue;
+        out.write(data, sections[i].bytes);
+        written = table[i].offset + sections[i].bytes;
+    }
+    out.close();
+    if (!out || rename(temporary.c_str(), path.c_str()) != 0) throw std::invalid_argument("Could not write snapshot " + path);
+}
+
+SnapshotReader::SnapshotReader(const string& path) : file(std::make_shared<MappedFile>(path)) {
+    if (file->size() < sizeof(SnapshotHeader)) throw std::runtime_error("Not a graph snapshot");
+    const SnapshotHeader& h = header();
+    if (memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0 || h.byteOrder != BYTE_ORDER_MARK) throw std::runtime_error("Not a graph snapshot");
+    if (h.version != VERSION) throw std::runtime_error("Snapshot version is out of date");
+    if (file->size() < sizeof(SnapshotHeader) + (uint64_t) h.sectionCount * sizeof(SnapshotSection)) throw std::runtime_error("Snapshot is truncated");
+
+    table = (const SnapshotSection*) (file->begin() + sizeof(SnapshotHeader));
+    for (uint32_t i = 0; i < h.sectionCount; i++) {
+        if (table[i].offset % 8 != 0 || table[i].offset + table[i].bytes > file->size()) throw std::runtime_error("Snapshot is truncated");
+    }
+}
+
+const SnapshotSection& SnapshotReader::nextSection(size_t elementSize) {
+    if (next >= header().sectionCount) throw std::runtime_error("Snapshot has too few sections");
+    const SnapshotSection& section = table[next++];
+    if (section.elementSize != elementSize || section.bytes % elementSize != 0) throw std::runtime_error("Snapshot section has the wrong type");
+    return section;
+}
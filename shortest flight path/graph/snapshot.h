@@ -0,0 +1,173 @@
+/**
+ * @file snapshot.h
+ */
+
+#pragma once
+
+#include "column.h"
+#include "csv.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+/**
+ * Identifies the contents of a source CSV file a snapshot was built from
+ */
+struct SourceFingerprint {
+    uint64_t size = 0;
+    int64_t modified = 0;
+    uint64_t hash = 0;
+
+    /**
+     * Reads the size, modification time and content hash of a file
+     * @param path Path to the file
+     * @return the fingerprint, or an all zero fingerprint if the file cannot be read
+     */
+    static SourceFingerprint of(const string& path);
+
+    /**
+     * Checks whether a file still matches this fingerprint. Size and modification time are compared first,
+     * and the content is only hashed when the modification time changed.
+     * @param path Path to the file
+     * @return true if the file has the contents this fingerprint was taken from
+     */
+    bool matches(const string& path) const;
+};
+
+/**
+ * Fixed layout at the start of every snapshot file, followed by a table of sections and then the section data
+ */
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t sectionCount;
+    uint32_t reserved;
+    SourceFingerprint airports;
+    SourceFingerprint routes;
+};
+
+/**
+ * Location of one section (one column or value) in a snapshot file
+ */
+struct SnapshotSection {
+    uint64_t offset;
+    uint64_t bytes;
+    uint64_t elementSize;
+};
+
+/**
+ * Checks rows of a compressed sparse row layout loaded from a snapshot, so a traversal cannot read outside the arrays
+ * @param offsets Start of each row in entries, followed by the entry count
+ * @param entries Vertex of every entry, row after row
+ * @param vertexCount Number of vertices an entry may name
+ * @return true if the offsets start at 0, never decrease and end at the entry count, and every entry is below vertexCount
+ */
+template <typename T>
+bool validRows(const Column<int>& offsets, const Column<T>& entries, size_t vertexCount) {
+    if (offsets.empty() || offsets[0] != 0 || (size_t) offsets[offsets.size() - 1] != entries.size()) return false;
+    for (size_t i = 1; i < offsets.size(); i++)
+        if (offsets[i - 1] > offsets[i]) return false;
+    for (T entry : entries)
+        if (entry < 0 || (size_t) entry >= vertexCount) return false;
+    return true;
+}
+
+/**
+ * Collects columns and values in order and writes them as one snapshot file.
+ * The memory behind each column must stay alive until write() returns.
+ */
+class SnapshotWriter {
+    public:
+
+    template <typename T>
+    void column(const Column<T>& values) {
+        Pending section;
+        section.data = (const char*) values.data();
+        section.bytes = values.size() * sizeof(T);
+        section.elementSize = sizeof(T);
+        sections.push_back(section);
+    }
+
+    template <typename T>
+    void value(const T& v) {
+        static_assert(sizeof(T) <= sizeof(uint64_t), "Snapshot values must fit in 8 bytes");
+        Pending section;
+        memcpy(&section.inlineValue, &v, sizeof(T));
+        section.bytes = sizeof(T);
+        section.elementSize = sizeof(T);
+        sections.push_back(section);
+    }
+
+    /**
+     * Writes the header, section table and every section to a file
+     * @param path Path of the snapshot file to create
+     * @param airports Fingerprint of the airport CSV the graph was built from
+     * @param routes Fingerprint of the route CSV the graph was built from
+     * @throws std::invalid_argument if the file cannot be written
+     */
+    void write(const string& path, const SourceFingerprint& airports, const SourceFingerprint& routes) const;
+
+    private:
+    // A section to write; values are copied into inlineValue and have no data pointer
+    struct Pending {
+        const char* data = nullptr;
+        uint64_t inlineValue = 0;
+        size_t bytes = 0;
+        size_t elementSize = 0;
+    };
+    vector<Pending> sections;
+};
+
+/**
+ * Memory-maps a snapshot file and hands out its sections, in the order they were written, as borrowed columns.
+ * Nothing is copied; the mapping stays alive as long as any column borrowed from it.
+ */
+class SnapshotReader {
+    public:
+
+    /**
+     * Maps and validates a snapshot file
+     * @param path Path of the snapshot file
+     * @throws std::invalid_argument if the file cannot be opened
+     * @throws std::runtime_error if the file is not a snapshot of the current version
+     */
+    SnapshotReader(const string& path);
+
+    const SnapshotHeader& header() const { return *(const SnapshotHeader*) file->begin(); }
+
+    template <typename T>
+    Column<T> column() {
+        const SnapshotSection& section = nextSection(sizeof(T));
+        return Column<T>::borrow((const T*) (file->begin() + section.offset), section.bytes / sizeof(T), file);
+    }
+
+    template <typename T>
+    T value() {
+        const SnapshotSection& section = nextSection(sizeof(T));
+        if (section.bytes != sizeof(T)) throw std::runtime_error("Snapshot section has the wrong size");
+        T v;
+        memcpy(&v, file->begin() + section.offset, sizeof(T));
+        return v;
+    }
+
+    /**
+     * Current snapshot format version; bump whenever the sections written by Graph change
+     */
+    static const uint32_t VERSION = 4;
+
+    private:
+    shared_ptr<MappedFile> file;
+    const SnapshotSection* table;
+    uint32_t next = 0;
+
+    const SnapshotSection& nextSection(size_t elementSize);
+};
@@ -0,0 +1,33 @@
+/**
+ * @file sptree.h
+ */
+
+#pragma once
+
+#include <climits>
+#include <cstddef>
+#include <vector>
+
+using std::vector;
+
+/**
+ * Result of a single-source shortest path search, indexed by dense airport index (see Graph::indexOf).
+ * dist holds the shortest distance from source (INT_MAX if unreachable) and
+ * parent holds the index of the previous airport on that shortest path (-1 for the source and unreachable airports).
+ */
+struct ShortestPathTree {
+    int source = -1;
+    vector<int> dist;
+    vector<int> parent;
+
+    /**
+     * @param v Dense airport index
+     * @return true if v was reached from the source
+     */
+    bool reached(int v) const { return v >= 0 && v < (int) dist.size() && dist[v] != INT_MAX; }
+
+    /**
+     * @return the bytes held by the distance and parent arrays
+     */
+    size_t bytes() const { return (dist.capacity() + parent.capacity()) * sizeof(int); }
+};
@@ -0,0 +1,95 @@
+#include "threadpool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threads) {
+    threads = std::max(1u, threads);
+    for (unsigned w = 0; w < threads; w++) queues.emplace_back(new Queue());
+    for (unsigned w = 0; w < threads; w++) workers.emplace_back(&ThreadPool::run, this, w);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+void ThreadPool::parallelFor(size_t count, const function<void(size_t, size_t, unsigned)>& body, size_t grain) {
+    if (count == 0) return;
+    grain = std::max<size_t>(1, grain);
+    std::lock_guard<std::mutex> batch(submit);
+
+    // Clear the last batch's error before any range is queued, so a worker that takes one early keeps its error
+    size_t ranges = (count + grain - 1) / grain;
+    std::unique_lock<std::mutex> guard(lock);
+    error = nullptr;
+    pending = ranges;
+    guard.unlock();
+
+    // Deal the ranges out round-robin so every worker starts on its own queue
+    for (size_t r = 0; r < ranges; r++) {
+        Queue& queue = *queues[r % queues.size()];
+        std::lock_guard<std::mutex> queued(queue.lock);
+        queue.tasks.push_back(Task{r * grain, std::min(count, (r + 1) * grain), &body});
+    }
+
+    // Bump the generation only once every range is queued, so no worker wakes to find its queues still empty
+    guard.lock();
+    generation++;
+    wake.notify_all();
+    done.wait(guard, [&]() { return pending == 0; });
+    if (error) std::rethrow_exception(error);
+}
+
+/**
+ * Pops a range from the back of the worker's own queue, or steals one from the front of another queue
+ * @param worker Index of the calling worker
+ * @param task Set to the range to run
+ * @return false if every queue is empty
+ */
+bool ThreadPool::take(unsigned worker, Task& task) {
+    for (size_t i = 0; i < queues.size(); i++) {
+        Queue& queue = *queues[(worker + i) % queues.size()];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (queue.tasks.empty()) continue;
+        if (i == 0) {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+        } else {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::run(unsigned worker) {
+    size_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [&]() { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+
+        Task task;
+        while (take(worker, task)) {
+            try {
+                (*task.body)(task.begin, task.end, worker);
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(lock);
+                if (!error) error = std::current_exception();
+            }
+            // The last range of the batch wakes the caller
+            if (--pending == 0) {
+                std::lock_guard<std::mutex> guard(lock);
+                done.notify_all();
+            }
+        }
+    }
+}
@@ -0,0 +1,88 @@
+/**
+ * @file threadpool.h
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using std::function;
+using std::vector;
+
+/**
+ * A fixed set of worker threads that run the chunks of a parallel loop with work stealing.
+ * Each worker owns a queue of index ranges; it takes ranges from the back of its own queue and, once that is empty,
+ * steals from the front of the others, so a worker that drew cheap queries keeps helping the ones that drew slow ones.
+ * Workers are numbered [0, size()), which lets callers keep scratch buffers per worker instead of per task.
+ */
+class ThreadPool {
+    public:
+
+    /**
+     * Starts the worker threads
+     * @param threads Number of workers; 0 is treated as 1
+     */
+    explicit ThreadPool(unsigned threads = std::thread::hardware_concurrency());
+
+    /**
+     * Waits for the workers to finish and joins them
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @return the number of worker threads
+     */
+    unsigned size() const { return (unsigned) workers.size(); }
+
+    /**
+     * Runs body over [0, count) split into ranges of at most grain indices and returns once every range is done.
+     * Batches from different callers run one after another. If a range throws, the remaining ranges still run and
+     * the first exception is rethrown here.
+     * @param count Number of indices
+     * @param body Called as body(begin, end, worker) for each range, where worker is in [0, size())
+     * @param grain Largest number of indices in one range
+     */
+    void parallelFor(size_t count, const function<void(size_t, size_t, unsigned)>& body, size_t grain = 16);
+
+    private:
+    struct Task {
+        size_t begin;
+        size_t end;
+        const function<void(size_t, size_t, unsigned)>* body;
+    };
+
+    struct Queue {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    vector<std::thread> workers;
+    vector<std::unique_ptr<Queue>> queues;
+
+    // Guards generation, stopping and error, and is held while waiting on wake and done
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable done;
+    size_t generation = 0;
+    bool stopping = false;
+    std::exception_ptr error;
+    std::atomic<size_t> pending{0};
+
+    // Serializes batches
+    std::mutex submit;
+
+    void run(unsigned worker);
+    bool take(unsigned worker, Task& task);
+};
@@ -0,0 +1,93 @@
+#include "treecache.h"
+
+TreeCache& TreeCache::operator=(const TreeCache& other) {
+    if (this == &other) return *this;
+    size_t budget = other.budget();
+    std::lock_guard<std::mutex> guard(lock);
+    order.clear();
+    index.clear();
+    used = 0;
+    limit = budget;
+    return *this;
+}
+
+shared_ptr<const ShortestPathTree> TreeCache::find(int source) {
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = index.find(source);
+    if (it == index.end()) {
+        counts.misses++;
+        return nullptr;
+    }
+    counts.hits++;
+    order.splice(order.begin(), order, it->second);
+    return it->second->second;
+}
+
+shared_ptr<const ShortestPathTree> TreeCache::insert(shared_ptr<const ShortestPathTree> tree) {
+    size_t bytes = tree->bytes();
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = index.find(tree->source);
+    if (it != index.end()) return it->second->second;
+    if (bytes > limit) return tree;
+
+    shrink(limit - bytes);
+    order.emplace_front(tree->source, tree);
+    index[tree->source] = order.begin();
+    used += bytes;
+    return tree;
+}
+
+void TreeCache::update(const std::function<shared_ptr<const ShortestPathTree>(const shared_ptr<const ShortestPathTree>&)>& repair) {
+    std::lock_guard<std::mutex> guard(lock);
+    for (auto it = order.begin(); it != order.end();) {
+        shared_ptr<const ShortestPathTree> repaired = repair(it->second);
+        used -= it->second->bytes();
+        if (!repaired) {
+            index.erase(it->first);
+            it = order.erase(it);
+            continue;
+        }
+        used += repaired->bytes();
+        it->second = std::move(repaired);
+        ++it;
+    }
+    shrink(limit);
+}
+
+void TreeCache::clear() {
+    std::lock_guard<std::mutex> guard(lock);
+    order.clear();
+    index.clear();
+    used = 0;
+}
+
+void TreeCache::setBudget(size_t budget) {
+    std::lock_guard<std::mutex> guard(lock);
+    limit = budget;
+    shrink(limit);
+}
+
+size_t TreeCache::budget() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return limit;
+}
+
+TreeCache::Stats TreeCache::stats() const {
+    std::lock_guard<std::mutex> guard(lock);
+    Stats current = counts;
+    current.entries = order.size();
+    current.bytes = used;
+    return current;
+}
+
+/**
+ * Evicts least recently used trees until at most budget bytes are cached. The caller holds the lock.
+ */
+void TreeCache::shrink(size_t budget) {
+    while (used > budget && !order.empty()) {
+        used -= order.back().second->bytes();
+        index.erase(order.back().first);
+        order.pop_back();
+        counts.evictions++;
+    }
+}
@@ -0,0 +1,97 @@
+/**
+ * @file treecache.h
+ */
+
+#pragma once
+
+#include "sptree.h"
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+using std::shared_ptr;
+
+/**
+ * A least-recently-used cache of shortest path trees keyed by the dense index of their source, bounded by the bytes
+ * their arrays take. Lookups and inserts take a short lock, so any number of threads can share one cache; trees are
+ * handed out as shared pointers, so a tree evicted while a reader still walks it stays alive until the reader is done.
+ * Copying a cache gives an empty cache with the same budget.
+ */
+class TreeCache {
+    public:
+
+    /**
+     * Hit, miss and eviction counts since the cache was created, and what it holds now
+     */
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+        size_t entries = 0;
+        size_t bytes = 0;
+    };
+
+    /**
+     * Creates an empty cache
+     * @param budget Most bytes of tree arrays to keep; 0 disables caching
+     */
+    explicit TreeCache(size_t budget = 64 << 20) : limit(budget) { }
+
+    TreeCache(const TreeCache& other) : limit(other.budget()) { }
+    TreeCache& operator=(const TreeCache& other);
+
+    /**
+     * Looks up the tree of a source, making it the most recently used, and counts a hit or a miss
+     * @param source Dense index of the source
+     * @return the tree, or nullptr if it is not cached
+     */
+    shared_ptr<const ShortestPathTree> find(int source);
+
+    /**
+     * Caches a tree, evicting the least recently used ones until the cache is within budget again. A tree larger
+     * than the whole budget is not kept. If another thread cached the same source first, its tree is kept instead.
+     * @param tree Tree to cache
+     * @return the tree now cached for its source, or tree itself if it was not kept
+     */
+    shared_ptr<const ShortestPathTree> insert(shared_ptr<const ShortestPathTree> tree);
+
+    /**
+     * Passes every cached tree to repair under the lock and caches what it returns in the tree's place, keeping the
+     * recency order. Returning the same pointer keeps a tree, returning nullptr drops it. Readers still holding an
+     * old tree keep seeing it unchanged.
+     * @param repair Maps a tree that was exact before an edge update to one that is exact after it
+     */
+    void update(const std::function<shared_ptr<const ShortestPathTree>(const shared_ptr<const ShortestPathTree>&)>& repair);
+
+    /**
+     * Drops every tree, keeping the counters
+     */
+    void clear();
+
+    /**
+     * Changes the budget, evicting trees until the cache fits
+     * @param budget Most bytes of tree arrays to keep
+     */
+    void setBudget(size_t budget);
+
+    size_t budget() const;
+    Stats stats() const;
+
+    private:
+    using Entry = std::pair<int, shared_ptr<const ShortestPathTree>>;
+
+    mutable std::mutex lock;
+    size_t limit;
+    size_t used = 0;
+    Stats counts;
+
+    // Most recently used first, with an index from source to list position
+    std::list<Entry> order;
+    std::unordered_map<int, std::list<Entry>::iterator> index;
+
+    void shrink(size_t budget);
+};
@@ -0,0 +1,148 @@
+/**
+ * @file workspace.h
+ */
+
+#pragma once
+
+#include "heap.h"
+
+#include <climits>
+#include <vector>
+
+using std::vector;
+
+/**
+ * Scratch state for one search: distances, parents and a heap for each direction, the cached lower bounds of a
+ * guided search, two queues for breadth-first and layered searches, and a distance and parent per vertex in each
+ * layer of a hop-limited search. It is sized to the vertex count once and kept between queries.
+ * Every vertex carries the generation it was last written in, and a vertex from an older generation reads as
+ * untouched, so reset() starts a new search in O(1) instead of refilling the arrays.
+ */
+class SearchWorkspace {
+    public:
+
+    /**
+     * Default constructor, creates a workspace for a graph with no vertices
+     */
+    SearchWorkspace() { }
+
+    /**
+     * Creates a workspace for a graph with the given number of vertices
+     * @param vertexCount Number of vertices
+     */
+    explicit SearchWorkspace(int vertexCount) { reset(vertexCount); }
+
+    /**
+     * Starts a new search, so every distance reads INT_MAX, every parent and estimate -1, and both heaps and the queue
+     * are empty. Only allocates when the vertex count changes.
+     * @param vertexCount Number of vertices in the graph being searched
+     */
+    void reset(int vertexCount) {
+        if ((int) entries.size() != vertexCount) {
+            entries.assign(vertexCount, Entry());
+            forwardHeap.resize(vertexCount);
+            backwardHeap.resize(vertexCount);
+            frontier.reserve(vertexCount);
+            nextFrontier.reserve(vertexCount);
+            layered.clear();
+            generation = 0;
+        } else {
+            forwardHeap.clear();
+            backwardHeap.clear();
+        }
+        frontier.clear();
+        nextFrontier.clear();
+
+        // Stamps from before a wraparound could look current again, so clear them all once every 2^32 searches
+        if (++generation == 0) {
+            for (auto& entry : entries) entry.stamp = 0;
+            for (auto& entry : layered) entry.stamp = 0;
+            generation = 1;
+        }
+    }
+
+    /**
+     * Makes room for a layered search after reset(), so every layerDist reads INT_MAX and every layerParent -1.
+     * Only allocates when more layers are needed than any search asked for before. Calling it again during a search
+     * to add layers keeps the ones already written.
+     * @param layers Number of layers
+     */
+    void resetLayers(int layers) {
+        size_t size = (size_t) layers * entries.size();
+        if (layered.size() < size) layered.resize(size);
+    }
+
+    /**
+     * @param v Vertex to look up
+     * @return true if anything was written for v since the last reset
+     */
+    bool touched(int v) const { return entries[v].stamp == generation; }
+
+    int& dist(int v) { return touch(v).dist; }
+    int& parent(int v) { return touch(v).parent; }
+    int& backwardDist(int v) { return touch(v).backwardDist; }
+    int& backwardParent(int v) { return touch(v).backwardParent; }
+    int& estimate(int v) { return touch(v).estimate; }
+    int& layerDist(int layer, int v) { return touchLayer(layer, v).dist; }
+    int& layerParent(int layer, int v) { return touchLayer(layer, v).parent; }
+
+    /**
+     * @param v Vertex to look up
+     * @return v's distance without marking it touched, INT_MAX if it was not written since the last reset
+     */
+    int distOf(int v) const { return touched(v) ? entries[v].dist : INT_MAX; }
+    int backwardDistOf(int v) const { return touched(v) ? entries[v].backwardDist : INT_MAX; }
+    int layerDistOf(int layer, int v) const {
+        const LayerEntry& entry = layered[(size_t) layer * entries.size() + v];
+        return entry.stamp == generation ? entry.dist : INT_MAX;
+    }
+
+    IndexedHeap<4>& heap() { return forwardHeap; }
+    IndexedHeap<4>& reverseHeap() { return backwardHeap; }
+
+    /**
+     * @return the queue of a breadth-first search, with capacity for every vertex
+     */
+    vector<int>& queue() { return frontier; }
+
+    /**
+     * @return a second queue, for the next level of a search that works one level at a time
+     */
+    vector<int>& nextQueue() { return nextFrontier; }
+
+    private:
+    // Everything a search keeps about one vertex, together so a lookup touches a single cache line
+    struct Entry {
+        int dist = INT_MAX;
+        int parent = -1;
+        int backwardDist = INT_MAX;
+        int backwardParent = -1;
+        int estimate = -1;
+        unsigned stamp = 0;
+    };
+
+    // What a layered search keeps about one vertex in one layer
+    struct LayerEntry {
+        int dist = INT_MAX;
+        int parent = -1;
+        unsigned stamp = 0;
+    };
+
+    Entry& touch(int v) {
+        Entry& entry = entries[v];
+        if (entry.stamp != generation) entry = Entry{INT_MAX, -1, INT_MAX, -1, -1, generation};
+        return entry;
+    }
+
+    LayerEntry& touchLayer(int layer, int v) {
+        LayerEntry& entry = layered[(size_t) layer * entries.size() + v];
+        if (entry.stamp != generation) entry = LayerEntry{INT_MAX, -1, generation};
+        return entry;
+    }
+
+    vector<Entry> entries;
+    vector<LayerEntry> layered;
+    IndexedHeap<4> forwardHeap, backwardHeap;
+    vector<int> frontier, nextFrontier;
+    unsigned generation = 0;
+};
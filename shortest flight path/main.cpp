@@ -1,16 +1,118 @@
 #include "graph/graph.h"
 #include "graph/edge.h"
+#include "graph/batch.h"
+#include "graph/server.h"
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <fstream>
 #include <iostream>
 using namespace std;
 
-int main() {
+//server that Ctrl-C should stop, if one is running; a lock-free atomic so the signal handler reads it safely
+std::atomic<QueryServer*> running{nullptr};
+
+void stopServer(int) {
+  QueryServer* server = running.load();
+  if (server) server->stop();
+}
+
+//parses a thread count or chunk size, returning 0 unless the whole argument is a number of at least 1
+unsigned parseCount(const string& arg) {
+  try {
+    size_t used;
+    int count = std::stoi(arg, &used);
+    if (used == arg.size() && count >= 1) return count;
+  } catch (std::logic_error& e) {
+  }
+  return 0;
+}
+
+//loads the graph once and answers route queries over a Unix socket until interrupted
+int serve(string path, unsigned threads) {
+  auto a = Graph("assets/airports.csv", "assets/routes.csv", "assets/graph.snapshot");
+  ThreadPool pool(threads);
+  QueryServer server(a, pool);
+  server.listen(path);
+  running.store(&server);
+  signal(SIGINT, stopServer);
+  signal(SIGTERM, stopServer);
+
+  std::cout << "Answering \"<from> <to>\" queries on " << path << " with " << pool.size() << " threads, Ctrl-C to stop" << std::endl;
+  server.run();
+  running.store(nullptr);
+  std::cout << "Answered " << server.answered() << " queries" << std::endl;
+  return 0;
+}
+
+//answers every origin/destination line of a file, or of stdin for "-", writing one result per line to stdout
+int batch(int argc, char* argv[]) {
+  string input = "-";
+  BatchOptions options;
+  unsigned threads = std::thread::hardware_concurrency();
+  const char* usage = "Usage: ./final_proj --batch [file|-] [--csv|--jsonl] [--unordered] [--threads N] [--chunk N], with N at least 1";
+  for (int i = 2; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "--jsonl") options.format = BatchOptions::Format::JSONL;
+    else if (arg == "--csv") options.format = BatchOptions::Format::CSV;
+    else if (arg == "--unordered") options.ordered = false;
+    else if ((arg == "--threads" || arg == "--chunk") && i + 1 < argc) {
+      unsigned count = parseCount(argv[++i]);
+      if (count == 0) {
+        std::cerr << usage << std::endl;
+        return 1;
+      }
+      if (arg == "--threads") threads = count;
+      else options.chunk = count;
+    }
+    else if (arg[0] != '-' || arg == "-") input = arg;
+    else {
+      std::cerr << usage << std::endl;
+      return 1;
+    }
+  }
+
+  std::ifstream file;
+  if (input != "-") {
+    file.open(input);
+    if (!file) {
+      std::cerr << "Cannot open " << input << std::endl;
+      return 1;
+    }
+  }
+  //reading stdin must not flush stdout from another thread
+  std::ios::sync_with_stdio(false);
+  std::cin.tie(nullptr);
+
+  auto a = Graph("assets/airports.csv", "assets/routes.csv", "assets/graph.snapshot");
+  ThreadPool pool(threads);
+  BatchStats stats = runBatch(a, input == "-" ? std::cin : file, std::cout, pool, options);
+  std::cerr << stats.queries << " queries: " << stats.found << " routes, " << stats.unreachable << " without a route, " << stats.errors << " errors" << std::endl;
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  //server mode: ./final_proj --serve [socket path] [threads]
+  if (argc > 1 && string(argv[1]) == "--serve") {
+    unsigned threads = argc > 3 ? parseCount(argv[3]) : std::thread::hardware_concurrency();
+    if (argc > 3 && threads == 0) {
+      std::cerr << "Usage: ./final_proj --serve [socket path] [threads, at least 1]" << std::endl;
+      return 1;
+    }
+    return serve(argc > 2 ? argv[2] : "final_proj.sock", threads);
+  }
+  //batch mode: ./final_proj --batch [file|-] [--csv|--jsonl] [--unordered] [--threads N] [--chunk N]
+  if (argc > 1 && string(argv[1]) == "--batch") {
+    return batch(argc, argv);
+  }
+  
   
   std::string source; //inputed source
   std::string destination; //inputed destination
   int s; //source converted to int
   int d; //destination converted to int
   bool ok = false; //whether or not user input is ok
-  auto a = Graph("assets/airports.csv", "assets/routes.csv"); //graph of all data
+  auto a = Graph("assets/airports.csv", "assets/routes.csv", "assets/graph.snapshot"); //graph of all data, cached as a binary snapshot
   
   //prompt user for inputs
   std::cout <<"\n" <<std::endl;
@@ -58,25 +160,26 @@ int main() {
   std::cout <<"Loading Flight Path..." <<std::endl;
   std::cout <<"" <<std::endl;
   
-  //path taken by djikstra
-  vector<Vertex> path;
-  a.findPath(s, d, path);
-  
-  int dist = 0; //total distance
+  //path taken by djikstra, along with the distance of every leg
+  ShortestPathResult route = a.shortestPath(s, d);
+  vector<Vertex>& path = route.path;
   
   //check if path is empty
-  if (path.size() == 0) {
+  if (!route.found()) {
+    std::cout << "No Route Exists" << std::endl;
     return 0;
   }
   //all flights available for each airport visited on dijkstra's
-  //uses BFS to list all fights
+  //lists the direct routes out of each airport, once per destination
   for (unsigned i = 0; i < path.size() - 1; i++){
-    vector<Airport> port = a.BFS(path[i]);
+    vector<Vertex> port = a.getOutgoing(path[i]);
+    std::sort(port.begin(), port.end());
+    port.erase(std::unique(port.begin(), port.end()), port.end());
     std::cout << "All Flights from ";
     std::cout << path[i];
     std::cout << ": ";
     for (auto j: port) {
-      std::cout << j.getCode();
+      std::cout << j;
       std::cout << " ";
     }
     std::cout << "\n";
@@ -91,12 +194,11 @@ int main() {
     std::cout << " -> " ;
     std::cout << e;
     std::cout << " Distance: ";
-    std::cout << a.getDistance(b,e);
+    std::cout << route.legDistances[i];
     std::cout << " km" <<std::endl;
-    dist += a.getDistance(b,e);
   }
   std::cout << "Total Flight Distance: ";
-  std::cout << dist;
+  std::cout << route.totalDistance;
   std::cout << " km" <<std::endl;
   
   a.graphAirportAndRouteVisualization(s,d);
@@ -2,14 +2,23 @@
 #include <vector>
 #include <unordered_map>
 #include <iostream>
+#include <sstream>
+#include <algorithm>
 
 
 #include "../graph/edge.h"
 #include "../graph/graph.h"
+#include "../graph/batch.h"
+#include "../graph/server.h"
+#include "../graph/snapshot.h"
 #include "catch/catch.hpp"
 #include "../cs225/HSLAPixel.h"
 #include "../cs225/PNG.h"
 
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
 using std::string;
 using std::vector;
 using std::unordered_map;
@@ -25,7 +34,7 @@ TEST_CASE("BFS traversal on simple dataset") {
 	vector<Airport> path = g.BFS(source);
 
 	SECTION("Check visited correct number of airports") {
-		REQUIRE(path.size() == 2);
+		REQUIRE(path.size() == 5);
 	}
 
 	SECTION("Check visited correct airport first") {
@@ -35,7 +44,9 @@ TEST_CASE("BFS traversal on simple dataset") {
 	SECTION("Visited airports in correct order") {
 		REQUIRE(path.at(0).getCode() == 1);
 		REQUIRE(path.at(1).getCode() == 2);
-		// REQUIRE(path.at(2).getCode() == 3);
+		REQUIRE(path.at(2).getCode() == 3);
+		REQUIRE(path.at(3).getCode() == 4);
+		REQUIRE(path.at(4).getCode() == 5);
 	}
 }
 
@@ -178,7 +189,7 @@ TEST_CASE("Source is Destination") {
 }
 
 TEST_CASE("Dijkstra no stops Large Dataset") {
-  auto g = Graph("assets/airports.csv", "assets/routes.csv");
+  auto g = Graph("assets/airports.csv", "assets/routes.csv", "assets/graph.snapshot");
   vector<Vertex> path;
   g.findPath(3830, 3093, path);
   
@@ -197,7 +208,7 @@ TEST_CASE("Dijkstra no stops Large Dataset") {
 }
 
 TEST_CASE("Dijkstra 1 stop Large Dataset") {
-  auto g = Graph("assets/airports.csv", "assets/routes.csv");
+  auto g = Graph("assets/airports.csv", "assets/routes.csv", "assets/graph.snapshot");
   vector<Vertex> path;
   g.findPath(2990, 4374, path);
   
@@ -217,7 +228,7 @@ TEST_CASE("Dijkstra 1 stop Large Dataset") {
 }
 
 TEST_CASE("Graph Visualization Colors Vertex for random airport Red") {
-  auto g = Graph("assets/airports.csv", "assets/routes.csv");
+  auto g = Graph("assets/airports.csv", "assets/routes.csv", "assets/graph.snapshot");
   g.graphAirportVisualization();
   PNG png;
   png.readFromFile("worldMapWithAirports.png");
@@ -226,4 +237,1112 @@ TEST_CASE("Graph Visualization Colors Vertex for random airport Red") {
   REQUIRE (pixel.s == 1);
   REQUIRE (pixel.l == .5);
   REQUIRE (pixel.a == 1);
-}
\ No newline at end of file
+}
+TEST_CASE("Heap Dijkstra distances on simple dataset") {
+  auto g = Graph("tests/simpleAirDij.csv", "tests/simpleRouDij.csv");
+  auto tree = g.shortestPathTree(1);
+
+  SECTION("Source has distance zero") {
+    REQUIRE(tree.dist[g.indexOf(1)] == 0);
+    REQUIRE(tree.parent[g.indexOf(1)] == -1);
+  }
+
+  SECTION("Distances accumulate along the route") {
+    REQUIRE(tree.dist[g.indexOf(2)] == 106);
+    REQUIRE(tree.dist[g.indexOf(3)] == 285);
+    REQUIRE(tree.dist[g.indexOf(4)] == 566);
+    REQUIRE(g.codeOf(tree.parent[g.indexOf(4)]) == 3);
+  }
+
+  SECTION("Unreachable airport is not reached") {
+    REQUIRE_FALSE(tree.reached(g.indexOf(5)));
+  }
+}
+
+TEST_CASE("CSR graph matches adjacency list") {
+  auto g = Graph("tests/simpleAirDij.csv", "tests/simpleRouDij.csv");
+  const CSRGraph& csr = g.getCSR();
+
+  SECTION("Edge count matches") {
+    REQUIRE(csr.edgeCount() == g.getEdgeCount());
+  }
+
+  SECTION("Outgoing arcs carry target and weight") {
+    auto out = csr.outgoing(g.indexOf(1));
+    REQUIRE(out.size() == 1);
+    REQUIRE(g.codeOf(out[0].vertex) == 2);
+    REQUIRE(out[0].weight == 106);
+  }
+
+  SECTION("Incoming arcs match getIncoming") {
+    vector<Vertex> sources;
+    for (auto arc : csr.incoming(g.indexOf(3))) sources.push_back(g.codeOf(arc.vertex));
+    REQUIRE(sources == g.getIncoming(3));
+  }
+}
+
+TEST_CASE("Dense ids round trip airport codes") {
+  auto g = Graph("assets/airports.csv", "assets/routes.csv");
+  const VertexIdMap& ids = g.getIdMap();
+
+  SECTION("Indices are contiguous") {
+    REQUIRE(ids.size() >= g.getVerticeCount());
+    REQUIRE(g.indexOf(1) == 0);
+    REQUIRE(g.codeOf(g.indexOf(3830)) == 3830);
+  }
+
+  SECTION("Unknown codes have no index") {
+    REQUIRE(g.indexOf(999999) == -1);
+    REQUIRE_FALSE(g.vertexExists(-5));
+  }
+
+  SECTION("IATA and ICAO codes resolve to the airport") {
+    REQUIRE(g.codeOf(ids.fromIATA("GKA")) == 1);
+    REQUIRE(g.codeOf(ids.fromICAO("AYMD")) == 2);
+    REQUIRE(ids.fromIATA("???") == -1);
+  }
+}
+
+TEST_CASE("CSV reader handles quoted fields") {
+  auto g = Graph("tests/quotedAirport.csv", "tests/quotedRoute.csv");
+
+  SECTION("Quotes are stripped from text fields") {
+    REQUIRE(g.getAirport(1).getName() == "Goroka Airport");
+    REQUIRE(g.getAirport(1).getCountry() == "Papua New Guinea");
+  }
+
+  SECTION("Escaped quotes are unescaped") {
+    REQUIRE(g.getAirport(332).getName() == "Magdeburg \"City\" Airport");
+  }
+
+  SECTION("Commas inside quotes do not shift later fields") {
+    REQUIRE(g.getAirport(7).getName() == "Narsarsuaq, Airport");
+    REQUIRE(g.getAirport(7).getLatitude() == Approx(61.1604995728));
+    REQUIRE(g.getAirport(7).getLongitude() == Approx(-45.4259986877));
+    REQUIRE(g.getEdgeCount() == 2);
+  }
+
+  SECTION("Null codes are not registered") {
+    REQUIRE(g.getAirport(7).getIATA() == "");
+    REQUIRE(g.codeOf(g.getIdMap().fromICAO("BGBW")) == 7);
+    REQUIRE(g.getIdMap().fromIATA("\\N") == -1);
+  }
+}
+
+TEST_CASE("Snapshot round trip") {
+  auto g = Graph("tests/simpleAirDij.csv", "tests/simpleRouDij.csv");
+  g.writeSnapshot("tests/simpleDij.snapshot", "tests/simpleAirDij.csv", "tests/simpleRouDij.csv");
+
+  Graph loaded;
+  REQUIRE(loaded.readSnapshot("tests/simpleDij.snapshot", "tests/simpleAirDij.csv", "tests/simpleRouDij.csv"));
+
+  SECTION("Counts and airports match") {
+    REQUIRE(loaded.getVerticeCount() == g.getVerticeCount());
+    REQUIRE(loaded.getEdgeCount() == g.getEdgeCount());
+    REQUIRE(loaded.getAirport(2).getName() == g.getAirport(2).getName());
+    REQUIRE(loaded.getAirport(2).getLatitude() == g.getAirport(2).getLatitude());
+    REQUIRE(loaded.codeOf(loaded.getIdMap().fromIATA("HGU")) == 3);
+  }
+
+  SECTION("Shortest paths match") {
+    REQUIRE(loaded.findPath(1, 4) == g.findPath(1, 4));
+    REQUIRE(loaded.getDistance(3, 4) == 281);
+  }
+
+  SECTION("Edges can still be inserted after loading") {
+    loaded.insertEdge(1, 4, 10);
+    REQUIRE(loaded.findPath(1, 4).size() == 2);
+  }
+
+  SECTION("Snapshot of different source files is rejected") {
+    Graph other;
+    REQUIRE_FALSE(other.readSnapshot("tests/simpleDij.snapshot", "tests/simpleAirDij.csv", "tests/simpleRoute.csv"));
+    REQUIRE_FALSE(other.readSnapshot("tests/missing.snapshot", "tests/simpleAirDij.csv", "tests/simpleRouDij.csv"));
+    REQUIRE(other.getEdgeCount() == 0);
+  }
+
+  SECTION("Snapshot edge arrays that would read out of bounds are rejected") {
+    // Three airports, with offsets and endpoints for routes 0 -> 1 and 1 -> 2
+    auto loads = [](vector<int> outOffsets, vector<int> outTargets, vector<int> inOffsets, vector<int> inSources) {
+      Column<int> columns[] = {outOffsets, outTargets, vector<int>(outTargets.size(), 1), inOffsets, inSources, vector<int>(inSources.size(), 1)};
+      SnapshotWriter writer;
+      for (auto& column : columns) writer.column(column);
+      writer.write("tests/corrupt.snapshot", SourceFingerprint(), SourceFingerprint());
+      SnapshotReader reader("tests/corrupt.snapshot");
+      CSRGraph graph;
+      try {
+        graph.load(reader);
+        return true;
+      } catch (std::runtime_error&) {
+        return false;
+      }
+    };
+    REQUIRE(loads({0, 1, 2, 2}, {1, 2}, {0, 0, 1, 2}, {0, 1}));
+    REQUIRE_FALSE(loads({0, 2, 1, 2}, {1, 2}, {0, 0, 1, 2}, {0, 1}));
+    REQUIRE_FALSE(loads({0, 1, 1, 1}, {1, 2}, {0, 0, 1, 2}, {0, 1}));
+    REQUIRE_FALSE(loads({0, 1, 2, 2}, {1, 3}, {0, 0, 1, 2}, {0, 1}));
+    REQUIRE_FALSE(loads({0, 1, 2, 2}, {1, 2}, {0, 0, 1, 2}, {-1, 1}));
+  }
+
+  SECTION("Snapshot airport tables that would look up the wrong airport are rejected") {
+    // Airport codes 1 and 3 at indices 0 and 1, with IATA keys packing "A" and "B"
+    uint64_t a = uint64_t('A') << 56, b = uint64_t('B') << 56;
+    auto loads = [](vector<int> codeToIndex, vector<int> indexToCode, vector<uint64_t> IATAKeys) {
+      Column<int> codes(codeToIndex), indices(indexToCode);
+      Column<uint64_t> IATA(IATAKeys), ICAO;
+      SnapshotWriter writer;
+      writer.column(codes);
+      writer.column(indices);
+      writer.column(IATA);
+      writer.column(ICAO);
+      writer.write("tests/corrupt.snapshot", SourceFingerprint(), SourceFingerprint());
+      SnapshotReader reader("tests/corrupt.snapshot");
+      VertexIdMap ids;
+      try {
+        ids.load(reader);
+        return true;
+      } catch (std::runtime_error&) {
+        return false;
+      }
+    };
+    REQUIRE(loads({-1, 0, -1, 1}, {1, 3}, {a, b | 1}));
+    REQUIRE_FALSE(loads({-1, 0, -1, 2}, {1, 3}, {a, b | 1}));
+    REQUIRE_FALSE(loads({-1, 1, -1, 0}, {1, 3}, {a, b | 1}));
+    REQUIRE_FALSE(loads({-1, 0, 0, 1}, {1, 3}, {a, b | 1}));
+    REQUIRE_FALSE(loads({-1, 0, -1, 1}, {1, 3}, {a, b | 2}));
+    REQUIRE_FALSE(loads({-1, 0, -1, 1}, {1, 3}, {b | 1, a}));
+  }
+
+  SECTION("Snapshot landmarks that are not airports are rejected") {
+    auto loads = [](vector<int> landmarks) {
+      Column<int> chosen(landmarks), forward(vector<int>(6, 0)), backward(vector<int>(6, 0));
+      SnapshotWriter writer;
+      writer.column(chosen);
+      writer.column(forward);
+      writer.column(backward);
+      writer.write("tests/corrupt.snapshot", SourceFingerprint(), SourceFingerprint());
+      SnapshotReader reader("tests/corrupt.snapshot");
+      Landmarks loaded;
+      try {
+        loaded.load(reader);
+        return true;
+      } catch (std::runtime_error&) {
+        return false;
+      }
+    };
+    REQUIRE(loads({0, 2}));
+    REQUIRE_FALSE(loads({0, 3}));
+    REQUIRE_FALSE(loads({-1, 2}));
+  }
+}
+
+TEST_CASE("Parallel route ingest matches serial ingest") {
+  Graph serial, parallel;
+  serial.readAirportCSV("assets/airports.csv");
+  parallel.readAirportCSV("assets/airports.csv");
+  serial.loadRouteCSV("assets/routes.csv");
+  parallel.loadRouteCSV("assets/routes.csv", 4);
+
+  REQUIRE(parallel.getEdgeCount() == serial.getEdgeCount());
+  REQUIRE(parallel.getCSR().vertexCount() == serial.getCSR().vertexCount());
+
+  // Edges are inserted in file order, so every row lists the same arcs in the same order
+  auto expected = serial.getCSR().edges();
+  auto actual = parallel.getCSR().edges();
+  REQUIRE(actual.size() == expected.size());
+  bool same = true;
+  for (size_t i = 0; i < expected.size(); i++)
+    same = same && parallel.codeOf(actual[i].source) == serial.codeOf(expected[i].source)
+                && parallel.codeOf(actual[i].target) == serial.codeOf(expected[i].target)
+                && actual[i].getWeight() == expected[i].getWeight();
+  REQUIRE(same);
+}
+
+TEST_CASE("Bidirectional Dijkstra matches single-source Dijkstra") {
+  auto g = Graph("assets/airports.csv", "assets/routes.csv", "assets/graph.snapshot");
+
+  SECTION("Simple dataset paths are unchanged") {
+    auto simple = Graph("tests/simpleAirDij.csv", "tests/simpleRouDij.csv");
+    REQUIRE(simple.shortestPath(1, 4).path == vector<Vertex>{1, 2, 3, 4});
+    REQUIRE(simple.shortestPath(3, 3).path == vector<Vertex>{3});
+    REQUIRE_FALSE(simple.shortestPath(1, 5).found());
+  }
+
+  SECTION("Path lengths equal the shortest distance") {
+    auto tree = g.shortestPathTree(3830);
+    int checked = 0;
+    for (int target = 0; target < (int) tree.dist.size(); target += 97) {
+      auto path = g.shortestPath(3830, g.codeOf(target)).path;
+      if (!tree.reached(target)) {
+        REQUIRE(path.empty());
+        continue;
+      }
+      int length = 0;
+      for (unsigned i = 1; i < path.size(); i++) length += g.getDistance(path[i - 1], path[i]);
+      REQUIRE(length == tree.dist[target]);
+      checked++;
+    }
+    REQUIRE(checked > 0);
+  }
+
+  SECTION("Settles fewer airports than a full search") {
+    int settled = g.shortestPath(2990, 4374).settled;
+    auto tree = g.shortestPathTree(2990);
+    int reached = 0;
+    for (int d : tree.dist) reached += d != INT_MAX;
+    REQUIRE(settled > 0);
+    REQUIRE(settled < reached);
+  }
+}
+
+TEST_CASE("Shortest path result carries leg distances") {
+  auto g = Graph("tests/simpleAirDij.csv", "tests/simpleRouDij.csv");
+
+  SECTION("Legs and total on a 2 stop route") {
+    for (auto algorithm : {PathAlgorithm::Dijkstra, PathAlgorithm::Bidirectional}) {
+      auto result = g.shortestPath(1, 4, algorithm);
+      REQUIRE(result.path == vector<Vertex>{1, 2, 3, 4});
+      REQUIRE(result.legDistances == vector<int>{106, 179, 281});
+      REQUIRE(result.totalDistance == 566);
+      REQUIRE(result.settled > 0);
+    }
+  }
+
+  SECTION("Source is destination") {
+    auto result = g.shortestPath(3, 3);
+    REQUIRE(result.path == vector<Vertex>{3});
+    REQUIRE(result.legDistances.empty());
+    REQUIRE(result.totalDistance == 0);
+  }
+
+  SECTION("No route") {
+    auto result = g.shortestPath(1, 5, PathAlgorithm::Dijkstra);
+    REQUIRE_FALSE(result.found());
+    REQUIRE(result.totalDistance == INT_MAX);
+  }
+}
+
+TEST_CASE("A* matches Dijkstra") {
+  auto g = Graph("assets/airports.csv", "assets/routes.csv", "assets/graph.snapshot");
+
+  SECTION("Simple dataset route") {
+    auto simple = Graph("tests/simpleAirDij.csv", "tests/simpleRouDij.csv");
+    auto result = simple.shortestPath(1, 4, PathAlgorithm::AStar);
+    REQUIRE(result.path == vector<Vertex>{1, 2, 3, 4});
+    REQUIRE(result.totalDistance == 566);
+  }
+
+  SECTION("Same distances and fewer settled airports on the full dataset") {
+    vector<pair<Vertex, Vertex>> pairs = {{3830, 3093}, {2990, 4374}, {3484, 3364}, {507, 3797}, {1382, 3577}};
+    for (auto& od : pairs) {
+      auto dijkstra = g.shortestPath(od.first, od.second, PathAlgorithm::Dijkstra);
+      auto astar = g.shortestPath(od.first, od.second, PathAlgorithm::AStar);
+      REQUIRE(astar.found() == dijkstra.found());
+      REQUIRE(astar.totalDistance == dijkstra.totalDistance);
+      REQUIRE(astar.settled <= dijkstra.settled);
+    }
+  }
+}
+
+TEST_CASE("ALT matches Dijkstra") {
+  auto g = Graph("assets/airports.csv", "assets/routes.csv", "assets/graph.snapshot");
+
+  SECTION("Landmarks are loaded with the snapshot") {
+    REQUIRE(g.getLandmarks().count() == 16);
+    REQUIRE(g.getLandmarks().vertexCount() == g.getCSR().vertexCount());
+  }
+
+  SECTION("Lower bounds never exceed the true distance") {
+    auto tree = g.shortestPathTree(2990);
+    int source = g.indexOf(2990);
+    for (int v = 0; v < (int) tree.dist.size(); v += 13) {
+      int bound = g.getLandmarks().lowerBound(source, v);
+      if (tree.reached(v)) REQUIRE(bound <= tree.dist[v]);
+      else REQUIRE(bound >= 0);
+    }
+  }
+
+  SECTION("Same distances and fewer settled airports on the full dataset") {
+    vector<pair<Vertex, Vertex>> pairs = {{3830, 3093}, {2990, 4374}, {3484, 3364}, {507, 3797}, {1382, 3577}, {1, 5}};
+    for (auto& od : pairs) {
+      auto dijkstra = g.shortestPath(od.first, od.second, PathAlgorithm::Dijkstra);
+      auto alt = g.shortestPath(od.first, od.second, PathAlgorithm::ALT);
+      REQUIRE(alt.found() == dijkstra.found());
+      REQUIRE(alt.totalDistance == dijkstra.totalDistance);
+      REQUIRE(alt.settled <= dijkstra.settled);
+    }
+  }
+
+  SECTION("Inserting an edge discards the landmarks") {
+    g.insertEdge(3830, 3093, 1);
+    REQUIRE(g.shortestPath(3830, 3093, PathAlgorithm::ALT).totalDistance == 1);
+    REQUIRE(g.getLandmarks().count() == 16);
+  }
+}
+
+TEST_CASE("Contraction Hierarchy matches Dijkstra") {
+  SECTION("Simple dataset route is unpacked into original routes") {
+    auto simple = Graph("tests/simpleAirDij.csv", "tests/simpleRouDij.csv");
+    auto result = simple.shortestPath(1, 4, PathAlgorithm::ContractionHierarchy);
+    REQUIRE(result.path == vector<Vertex>{1, 2, 3, 4});
+    REQUIRE(result.legDistances == vector<int>{106, 179, 281});
+    REQUIRE_FALSE(simple.shortestPath(1, 5, PathAlgorithm::ContractionHierarchy).found());
+  }
+
+  auto g = Graph("assets/airports.csv", "assets/routes.csv", "assets/graph.snapshot");
+
+  SECTION("Hierarchy is loaded with the snapshot") {
+    REQUIRE(g.getContractionHierarchy().vertexCount() == g.getCSR().vertexCount());
+    REQUIRE(g.getContractionHierarchy().shortcutCount() > 0);
+  }
+
+  SECTION("Same distances on the full dataset") {
+    auto tree = g.shortestPathTree(507);
+    for (int target = 0; target < (int) tree.dist.size(); target += 31) {
+      auto result = g.shortestPath(507, g.codeOf(target), PathAlgorithm::ContractionHierarchy);
+      REQUIRE(result.found() == tree.reached(target));
+      if (!result.found()) continue;
+      REQUIRE(result.totalDistance == tree.dist[target]);
+      REQUIRE(result.path.front() == 507);
+      REQUIRE(result.path.back() == g.codeOf(target));
+    }
+  }
+
+  SECTION("Parallel contraction gives correct distances") {
+    ThreadPool pool(4);
+    g.prepareContractionHierarchy(pool);
+    auto dijkstra = g.shortestPath(2990, 4374, PathAlgorithm::Dijkstra);
+    auto hierarchy = g.shortestPath(2990, 4374, PathAlgorithm::ContractionHierarchy);
+    REQUIRE(hierarchy.totalDistance == dijkstra.totalDistance);
+    REQUIRE(hierarchy.settled < dijkstra.settled);
+  }
+}
+
+TEST_CASE("Hub labels match Dijkstra") {
+  SECTION("Simple dataset") {
+    auto simple = Graph("tests/simpleAirDij.csv", "tests/simpleRouDij.csv");
+    REQUIRE(simple.shortestDistance(1, 4) == 566);
+    REQUIRE(simple.shortestDistance(4, 1) == INT_MAX);
+    REQUIRE(simple.shortestDistance(1, 5) == INT_MAX);
+    REQUIRE(simple.shortestPath(1, 4, PathAlgorithm::HubLabels).path == vector<Vertex>{1, 2, 3, 4});
+  }
+
+  auto g = Graph("assets/airports.csv", "assets/routes.csv", "assets/graph.snapshot");
+
+  SECTION("Labels are loaded with the snapshot") {
+    REQUIRE(g.getHubLabels().vertexCount() == g.getCSR().vertexCount());
+    REQUIRE(g.getHubLabels().entryCount() > 0);
+  }
+
+  SECTION("Same distances and path lengths on the full dataset") {
+    auto tree = g.shortestPathTree(3830);
+    for (int target = 0; target < (int) tree.dist.size(); target += 29) {
+      REQUIRE(g.shortestDistance(3830, g.codeOf(target)) == tree.dist[target]);
+      auto result = g.shortestPath(3830, g.codeOf(target), PathAlgorithm::HubLabels);
+      REQUIRE(result.found() == tree.reached(target));
+      if (result.found()) REQUIRE(result.totalDistance == tree.dist[target]);
+    }
+  }
+}
+
+TEST_CASE("Distance matrix matches single-source Dijkstra") {
+  SECTION("Simple dataset") {
+    auto simple = Graph("tests/simpleAirDij.csv", "tests/simpleRouDij.csv");
+    auto matrix = simple.distanceMatrix({1, 2, 5}, {1, 3, 4});
+    REQUIRE(matrix == vector<int>{0, 285, 566, INT_MAX, 179, 460, INT_MAX, INT_MAX, INT_MAX});
+  }
+
+  SECTION("Full dataset") {
+    auto g = Graph("assets/airports.csv", "assets/routes.csv", "assets/graph.snapshot");
+    vector<Vertex> sources = {3830, 2990, 507, 1382};
+    vector<Vertex> targets;
+    for (int index = 0; index < g.getCSR().vertexCount(); index += 53) targets.push_back(g.codeOf(index));
+    auto matrix = g.distanceMatrix(sources, targets);
+    REQUIRE(matrix.size() == sources.size() * targets.size());
+    for (size_t i = 0; i < sources.size(); i++) {
+      auto tree = g.shortestPathTree(sources[i]);
+      for (size_t j = 0; j < targets.size(); j++) REQUIRE(matrix[i * targets.size() + j] == tree.dist[g.indexOf(targets[j])]);
+    }
+  }
+}
+
+TEST_CASE("Thread pool runs every index once") {
+  ThreadPool pool(4);
+  REQUIRE(pool.size() == 4);
+
+  SECTION("Every index is covered exactly once") {
+    vector<int> hits(1000, 0);
+    vector<int> workers(1000, -1);
+    pool.parallelFor(hits.size(), [&](size_t begin, size_t end, unsigned worker) {
+      for (size_t i = begin; i < end; i++) {
+        hits[i]++;
+        workers[i] = worker;
+      }
+    }, 7);
+    for (size_t i = 0; i < hits.size(); i++) {
+      REQUIRE(hits[i] == 1);
+      REQUIRE(workers[i] >= 0);
+      REQUIRE(workers[i] < 4);
+    }
+  }
+
+  SECTION("Exceptions reach the caller and the pool stays usable") {
+    REQUIRE_THROWS_AS(pool.parallelFor(100, [](size_t begin, size_t, unsigned) {
+      if (begin == 48) throw std::runtime_error("range failed");
+    }), std::runtime_error);
+    std::atomic<int> count{0};
+    pool.parallelFor(100, [&](size_t begin, size_t end, unsigned) { count += (int) (end - begin); });
+    REQUIRE(count == 100);
+  }
+}
+
+TEST_CASE("Batched queries match single queries") {
+  auto g = Graph("assets/airports.csv", "assets/routes.csv", "assets/graph.snapshot");
+  vector<pair<Vertex, Vertex>> queries;
+  for (int index = 0; index < g.getCSR().vertexCount(); index += 97) queries.push_back({3830, g.codeOf(index)});
+  queries.push_back({3830, 3830});
+  queries.push_back({3830, 999999});
+  ThreadPool pool(3);
+
+  for (auto algorithm : {PathAlgorithm::Dijkstra, PathAlgorithm::Bidirectional, PathAlgorithm::AStar, PathAlgorithm::ALT,
+                         PathAlgorithm::ContractionHierarchy, PathAlgorithm::HubLabels}) {
+    g.prepare(algorithm);
+    auto results = g.shortestPaths(queries, algorithm, pool);
+    REQUIRE(results.size() == queries.size());
+    for (size_t i = 0; i < queries.size(); i++) {
+      auto expected = g.shortestPath(queries[i].first, queries[i].second, algorithm);
+      REQUIRE(results[i].path == expected.path);
+      REQUIRE(results[i].totalDistance == expected.totalDistance);
+    }
+  }
+
+  SECTION("Read-only queries refuse a graph with unfrozen edges") {
+    SearchWorkspace workspace;
+    g.insertEdge(3830, 2990, 100);
+    REQUIRE_THROWS_AS(g.shortestPath(3830, 2990, PathAlgorithm::Dijkstra, workspace), std::logic_error);
+    REQUIRE_THROWS_AS(g.shortestPaths(queries, PathAlgorithm::Dijkstra, pool), std::logic_error);
+    g.prepare(PathAlgorithm::Dijkstra);
+    REQUIRE(g.shortestPath(3830, 2990, PathAlgorithm::Dijkstra, workspace).totalDistance == 100);
+  }
+}
+
+TEST_CASE("Search workspace resets between queries") {
+  SECTION("Reset forgets everything written") {
+    SearchWorkspace workspace(5);
+    workspace.dist(2) = 7;
+    workspace.parent(2) = 1;
+    workspace.heap().push(2, 7);
+    REQUIRE(workspace.touched(2));
+    workspace.reset(5);
+    REQUIRE_FALSE(workspace.touched(2));
+    REQUIRE(workspace.distOf(2) == INT_MAX);
+    REQUIRE(workspace.parent(2) == -1);
+    REQUIRE(workspace.estimate(2) == -1);
+    REQUIRE(workspace.heap().empty());
+  }
+
+  SECTION("One workspace answers a mix of engines like new ones") {
+    auto g = Graph("assets/airports.csv", "assets/routes.csv", "assets/graph.snapshot");
+    for (auto algorithm : {PathAlgorithm::Dijkstra, PathAlgorithm::Bidirectional, PathAlgorithm::AStar, PathAlgorithm::ALT}) g.prepare(algorithm);
+    SearchWorkspace reused;
+    for (int index = 0; index < g.getCSR().vertexCount(); index += 211) {
+      Vertex target = g.codeOf(index);
+      for (auto algorithm : {PathAlgorithm::Dijkstra, PathAlgorithm::Bidirectional, PathAlgorithm::AStar, PathAlgorithm::ALT}) {
+        SearchWorkspace fresh;
+        auto expected = g.shortestPath(3830, target, algorithm, fresh);
+        auto result = g.shortestPath(3830, target, algorithm, reused);
+        REQUIRE(result.path == expected.path);
+        REQUIRE(result.settled == expected.settled);
+      }
+      SearchWorkspace fresh;
+      REQUIRE(g.BFS(target, reused).size() == g.BFS(target, fresh).size());
+    }
+  }
+}
+
+TEST_CASE("Direction-optimizing BFS finds fewest hops") {
+  SECTION("Simple dataset") {
+    Graph g("tests/simpleAirport.csv", "tests/simpleRoute.csv");
+    auto tree = g.hopTree(1);
+    vector<int> hops, parents;
+    for (Vertex v : {1, 2, 3, 4, 5}) {
+      hops.push_back(tree.hops[g.indexOf(v)]);
+      parents.push_back(tree.parent[g.indexOf(v)] == -1 ? -1 : g.codeOf(tree.parent[g.indexOf(v)]));
+    }
+    REQUIRE(hops == vector<int>{0, 1, 2, 2, 2});
+    REQUIRE(parents == vector<int>{-1, 1, 2, 2, 2});
+    REQUIRE_FALSE(g.hopTree(5).reached(g.indexOf(1)));
+    REQUIRE_FALSE(g.hopTree(999999).reached(0));
+  }
+
+  SECTION("Full dataset matches the queue-based BFS, with and without a pool") {
+    auto g = Graph("assets/airports.csv", "assets/routes.csv", "assets/graph.snapshot");
+    const CSRGraph& graph = g.getCSR();
+    ThreadPool pool(4);
+    for (Vertex source : {3830, 1, 2990}) {
+      // The queue-based traversal visits exactly the reachable airports
+      auto order = g.BFS(source);
+      auto serial = g.hopTree(source);
+      auto parallel = g.hopTree(source, &pool);
+      REQUIRE(serial.hops == parallel.hops);
+
+      int reached = 0;
+      for (int v = 0; v < graph.vertexCount(); v++) {
+        if (!serial.reached(v)) continue;
+        reached++;
+        // Every airport but the source is one hop past its parent, and no route reaches it any sooner
+        if (v != serial.source) {
+          REQUIRE(serial.hops[serial.parent[v]] + 1 == serial.hops[v]);
+          REQUIRE(parallel.hops[parallel.parent[v]] + 1 == parallel.hops[v]);
+        }
+        for (auto arc : graph.outgoing(v)) REQUIRE(serial.hops[arc.vertex] <= serial.hops[v] + 1);
+      }
+      REQUIRE(reached == (int) order.size());
+    }
+  }
+}
+
+TEST_CASE("Hop-limited shortest paths respect the stop limit") {
+  SECTION("Simple dataset") {
+    auto g = Graph("tests/simpleAirDij.csv", "tests/simpleRouDij.csv");
+    REQUIRE(g.shortestPathWithStops(1, 4, 2).path == vector<Vertex>{1, 2, 3, 4});
+    REQUIRE(g.shortestPathWithStops(1, 4, 2).totalDistance == 566);
+    REQUIRE_FALSE(g.shortestPathWithStops(1, 4, 1).found());
+    REQUIRE(g.shortestPathWithStops(1, 2, 0).totalDistance == 106);
+    REQUIRE(g.shortestPathWithStops(1, 1, 0).path == vector<Vertex>{1});
+    REQUIRE_THROWS_AS(g.shortestPathWithStops(1, 4, -1), std::invalid_argument);
+
+    // A direct but longer route wins only when connections are not allowed
+    g.insertEdge(1, 4, 1000);
+    REQUIRE(g.shortestPathWithStops(1, 4, 0).path == vector<Vertex>{1, 4});
+    REQUIRE(g.shortestPathWithStops(1, 4, 1).totalDistance == 1000);
+    REQUIRE(g.shortestPathWithStops(1, 4, 2).totalDistance == 566);
+  }
+
+  SECTION("An unbounded stop limit gives the unrestricted shortest path") {
+    auto g = Graph("assets/airports.csv", "assets/routes.csv", "assets/graph.snapshot");
+    for (auto od : vector<pair<Vertex, Vertex>>{{2990, 4374}, {3830, 2990}, {2990, 3830}}) {
+      auto result = g.shortestPathWithStops(od.first, od.second, INT_MAX);
+      REQUIRE(result.totalDistance == g.shortestPath(od.first, od.second).totalDistance);
+    }
+  }
+
+  SECTION("Full dataset matches Bellman-Ford limited to k + 1 rounds") {
+    auto g = Graph("assets/airports.csv", "assets/routes.csv", "assets/graph.snapshot");
+    const CSRGraph& graph = g.getCSR();
+    auto edges = graph.edges();
+    ThreadPool pool(2);
+    for (Vertex source : {3830, 2990}) {
+      vector<int> best(graph.vertexCount(), INT_MAX);
+      best[g.indexOf(source)] = 0;
+      vector<pair<Vertex, Vertex>> queries;
+      for (int target = 0; target < graph.vertexCount(); target += 41) queries.push_back({source, g.codeOf(target)});
+
+      for (int stops = 0; stops <= 3; stops++) {
+        // One more leg per round, relaxing from the previous round only
+        vector<int> previous = best;
+        for (auto& edge : edges)
+          if (previous[edge.source] != INT_MAX) best[edge.target] = min(best[edge.target], previous[edge.source] + (int) edge.getWeight());
+
+        auto batch = g.shortestPathsWithStops(queries, stops, pool);
+        for (size_t i = 0; i < queries.size(); i++) {
+          int target = g.indexOf(queries[i].second);
+          auto result = g.shortestPathWithStops(source, queries[i].second, stops);
+          REQUIRE(result.totalDistance == best[target]);
+          REQUIRE(batch[i].totalDistance == best[target]);
+          if (result.found()) REQUIRE((int) result.legDistances.size() <= stops + 1);
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE("Pareto routes trade legs against distance") {
+  SECTION("Simple dataset") {
+    auto g = Graph("tests/simpleAirDij.csv", "tests/simpleRouDij.csv");
+    g.insertEdge(1, 4, 1000);
+    g.insertEdge(1, 3, 400);
+    auto front = g.paretoRoutes(1, 4);
+    REQUIRE(front.size() == 3);
+    REQUIRE(front[0].legs == 1);
+    REQUIRE(front[0].distance == 1000);
+    REQUIRE(front[0].path == vector<Vertex>{1, 4});
+    REQUIRE(front[1].legs == 2);
+    REQUIRE(front[1].distance == 681);
+    REQUIRE(front[1].path == vector<Vertex>{1, 3, 4});
+    REQUIRE(front[2].legs == 3);
+    REQUIRE(front[2].distance == 566);
+    REQUIRE(front[2].path == vector<Vertex>{1, 2, 3, 4});
+
+    REQUIRE(g.paretoRoutes(1, 4, 2).size() == 2);
+    REQUIRE(g.paretoRoutes(4, 1).empty());
+    REQUIRE(g.paretoRoutes(1, 1).size() == 1);
+  }
+
+  SECTION("Full dataset front matches the hop-limited shortest paths") {
+    auto g = Graph("assets/airports.csv", "assets/routes.csv", "assets/graph.snapshot");
+    for (auto od : vector<pair<Vertex, Vertex>>{{3830, 2990}, {507, 3361}, {1382, 3205}, {2990, 4374}}) {
+      auto front = g.paretoRoutes(od.first, od.second);
+      REQUIRE_FALSE(front.empty());
+      REQUIRE(front.back().distance == g.shortestPath(od.first, od.second).totalDistance);
+
+      // A route with h legs is on the front exactly when it beats every route with fewer legs
+      vector<pair<int, int>> expected;
+      int previous = INT_MAX;
+      for (int legs = 1; legs <= front.back().legs; legs++) {
+        int distance = g.shortestPathWithStops(od.first, od.second, legs - 1).totalDistance;
+        if (distance < previous) expected.push_back({legs, distance});
+        previous = min(previous, distance);
+      }
+      vector<pair<int, int>> actual;
+      for (auto& route : front) {
+        actual.push_back({route.legs, route.distance});
+        REQUIRE((int) route.path.size() == route.legs + 1);
+      }
+      REQUIRE(actual == expected);
+    }
+  }
+}
+
+TEST_CASE("K shortest loopless paths") {
+  SECTION("Simple dataset lists every loopless route in order") {
+    Graph g("tests/simpleAirport.csv", "tests/simpleRoute.csv");
+    auto routes = g.kShortestPaths(1, 5, 10);
+    REQUIRE(routes.size() == 3);
+
+    // Every loopless route from 1 to 5, found by depth-first search
+    vector<pair<int, vector<Vertex>>> expected;
+    std::function<void(vector<Vertex>&, int)> extend = [&](vector<Vertex>& path, int distance) {
+      if (path.back() == 5) {
+        expected.push_back({distance, path});
+        return;
+      }
+      for (Vertex next : g.getOutgoing(path.back())) {
+        if (std::find(path.begin(), path.end(), next) != path.end()) continue;
+        path.push_back(next);
+        extend(path, distance + (int) g.getDistance(path[path.size() - 2], next));
+        path.pop_back();
+      }
+    };
+    vector<Vertex> start = {1};
+    extend(start, 0);
+    std::sort(expected.begin(), expected.end());
+    for (size_t i = 0; i < routes.size(); i++) {
+      REQUIRE(routes[i].totalDistance == expected[i].first);
+      REQUIRE(routes[i].path == expected[i].second);
+    }
+    REQUIRE(g.kShortestPaths(5, 1, 3).empty());
+    REQUIRE(g.kShortestPaths(1, 5, 0).empty());
+  }
+
+  SECTION("Full dataset routes are distinct, loopless and in order") {
+    auto g = Graph("assets/airports.csv", "assets/routes.csv", "assets/graph.snapshot");
+    for (auto od : vector<pair<Vertex, Vertex>>{{3830, 2990}, {2990, 4374}, {507, 3361}}) {
+      auto routes = g.kShortestPaths(od.first, od.second, 8);
+      REQUIRE(routes.size() == 8);
+      REQUIRE(routes[0].totalDistance == g.shortestPath(od.first, od.second).totalDistance);
+      for (size_t i = 0; i < routes.size(); i++) {
+        auto sorted = routes[i].path;
+        std::sort(sorted.begin(), sorted.end());
+        REQUIRE(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());
+        REQUIRE(routes[i].path.front() == od.first);
+        REQUIRE(routes[i].path.back() == od.second);
+        for (size_t leg = 0; leg < routes[i].legDistances.size(); leg++) REQUIRE(routes[i].legDistances[leg] != INT_MAX);
+        if (i > 0) REQUIRE(routes[i].totalDistance >= routes[i - 1].totalDistance);
+        for (size_t j = 0; j < i; j++) REQUIRE(routes[i].path != routes[j].path);
+      }
+    }
+  }
+}
+
+TEST_CASE("Shortest path tree cache") {
+  SECTION("Least recently used trees are evicted first") {
+    auto tree = [](int source) {
+      auto t = std::make_shared<ShortestPathTree>();
+      t->source = source;
+      t->dist.assign(10, 0);
+      t->parent.assign(10, -1);
+      return std::shared_ptr<const ShortestPathTree>(t);
+    };
+    size_t bytes = tree(0)->bytes();
+    TreeCache cache(2 * bytes);
+    REQUIRE(cache.find(1) == nullptr);
+    cache.insert(tree(1));
+    cache.insert(tree(2));
+    REQUIRE(cache.find(1) != nullptr);
+    cache.insert(tree(3));
+    REQUIRE(cache.find(2) == nullptr);
+    REQUIRE(cache.find(1) != nullptr);
+    REQUIRE(cache.find(3) != nullptr);
+
+    auto stats = cache.stats();
+    REQUIRE(stats.hits == 3);
+    REQUIRE(stats.misses == 2);
+    REQUIRE(stats.evictions == 1);
+    REQUIRE(stats.entries == 2);
+    REQUIRE(stats.bytes == 2 * bytes);
+
+    // A reader keeps its tree even after the cache lets go of it
+    auto held = cache.find(1);
+    cache.setBudget(0);
+    REQUIRE(cache.stats().entries == 0);
+    REQUIRE(held->source == 1);
+  }
+
+  SECTION("Cached trees answer queries like Dijkstra and are dropped when edges change") {
+    auto g = Graph("tests/simpleAirDij.csv", "tests/simpleRouDij.csv");
+    auto miss = g.shortestPath(1, 4, PathAlgorithm::CachedTree);
+    auto hit = g.shortestPath(1, 3, PathAlgorithm::CachedTree);
+    REQUIRE(miss.path == vector<Vertex>{1, 2, 3, 4});
+    REQUIRE(miss.totalDistance == 566);
+    REQUIRE(miss.settled == 4);
+    REQUIRE(hit.totalDistance == 285);
+    REQUIRE(hit.settled == 0);
+    REQUIRE(g.getTreeCache().stats().hits == 1);
+
+    g.insertEdge(1, 4, 100);
+    REQUIRE(g.shortestPath(1, 4, PathAlgorithm::CachedTree).totalDistance == 100);
+    REQUIRE(g.getTreeCache().stats().misses == 2);
+  }
+
+  SECTION("Concurrent readers agree with Dijkstra") {
+    auto g = Graph("assets/airports.csv", "assets/routes.csv", "assets/graph.snapshot");
+    g.getTreeCache().setBudget(4 * 2 * sizeof(int) * g.getCSR().vertexCount());
+    vector<pair<Vertex, Vertex>> queries;
+    for (int i = 0; i < 400; i++) queries.push_back({vector<Vertex>{3830, 2990, 507, 1382, 3361, 4374}[i % 6], g.codeOf((i * 37) % g.getCSR().vertexCount())});
+    ThreadPool pool(4);
+    auto cached = g.shortestPaths(queries, PathAlgorithm::CachedTree, pool);
+    auto plain = g.shortestPaths(queries, PathAlgorithm::Dijkstra, pool);
+    for (size_t i = 0; i < queries.size(); i++) REQUIRE(cached[i].totalDistance == plain[i].totalDistance);
+    REQUIRE(g.getTreeCache().stats().entries <= 4);
+    REQUIRE(g.getTreeCache().stats().evictions > 0);
+  }
+}
+
+TEST_CASE("Route updates repair cached trees") {
+  SECTION("Small graph updates change answers and edge counts") {
+    auto g = Graph("tests/simpleAirDij.csv", "tests/simpleRouDij.csv");
+    REQUIRE(g.shortestPath(1, 4, PathAlgorithm::CachedTree).totalDistance == 566);
+    int edges = g.getEdgeCount();
+
+    g.addRoute(1, 4, 100);
+    REQUIRE(g.getEdgeCount() == edges + 1);
+    auto shortcut = g.shortestPath(1, 4, PathAlgorithm::CachedTree);
+    REQUIRE(shortcut.path == vector<Vertex>{1, 4});
+    REQUIRE(shortcut.settled == 0);
+
+    REQUIRE(g.setRouteWeight(1, 4, 1000));
+    REQUIRE(g.shortestPath(1, 4, PathAlgorithm::CachedTree).totalDistance == 566);
+    REQUIRE(g.removeRoute(1, 4));
+    REQUIRE_FALSE(g.removeRoute(1, 4));
+    REQUIRE(g.getEdgeCount() == edges);
+
+    REQUIRE(g.removeRoute(2, 3));
+    REQUIRE_FALSE(g.shortestPath(1, 4, PathAlgorithm::CachedTree).found());
+    REQUIRE_FALSE(g.shortestPath(1, 4).found());
+    REQUIRE(g.getTreeCache().stats().misses == 1);
+    REQUIRE_THROWS_AS(g.addRoute(1, 99, 10), std::invalid_argument);
+  }
+
+  SECTION("Fractional weights are truncated like inserted edges") {
+    auto updated = Graph("tests/simpleAirDij.csv", "tests/simpleRouDij.csv");
+    auto inserted = Graph("tests/simpleAirDij.csv", "tests/simpleRouDij.csv");
+    updated.shortestPath(1, 4, PathAlgorithm::CachedTree);
+    updated.addRoute(1, 4, 99.9);
+    inserted.insertEdge(1, 4, 99.9);
+    REQUIRE(updated.shortestPath(1, 4, PathAlgorithm::CachedTree).totalDistance == 99);
+    REQUIRE(inserted.shortestPath(1, 4).totalDistance == 99);
+
+    REQUIRE(updated.setRouteWeight(1, 4, 500.7));
+    REQUIRE(updated.shortestPath(1, 4, PathAlgorithm::CachedTree).totalDistance == 500);
+    REQUIRE_THROWS_AS(updated.setRouteWeight(1, 4, -0.5), std::invalid_argument);
+  }
+
+  SECTION("Repaired trees match trees built from scratch") {
+    auto g = Graph("assets/airports.csv", "assets/routes.csv", "assets/graph.snapshot");
+    vector<Vertex> sources{3830, 2990, 507, 1382, 3361, 4374};
+    for (Vertex s : sources) g.shortestPath(s, s == 3830 ? 2990 : 3830, PathAlgorithm::CachedTree);
+
+    for (int i = 0; i < 60; i++) {
+      // Cut, reweight or restore an arc on some cached tree
+      Vertex source = sources[i % sources.size()];
+      auto tree = g.getTreeCache().find(g.indexOf(source));
+      REQUIRE(tree != nullptr);
+      int v = (i * 7919) % g.getCSR().vertexCount();
+      while (!tree->reached(v) || v == tree->source) v = (v + 1) % g.getCSR().vertexCount();
+      int u = tree->parent[v];
+      int weight = g.getCSR().weight(u, v);
+      if (i % 3 == 0) {
+        REQUIRE(g.removeRoute(g.codeOf(u), g.codeOf(v)));
+      } else if (i % 3 == 1) {
+        REQUIRE(g.setRouteWeight(g.codeOf(u), g.codeOf(v), weight * 3));
+      } else {
+        g.addRoute(g.codeOf(u), g.codeOf(v), weight / 2);
+      }
+
+      for (Vertex s : sources) {
+        auto repaired = g.getTreeCache().find(g.indexOf(s));
+        REQUIRE(repaired != nullptr);
+        REQUIRE(repaired->dist == g.shortestPathTree(s).dist);
+        for (int x = 0; x < (int) repaired->parent.size(); x++)
+          if (repaired->parent[x] != -1) REQUIRE(repaired->dist[repaired->parent[x]] + g.getCSR().weight(repaired->parent[x], x) == repaired->dist[x]);
+      }
+    }
+  }
+}
+
+TEST_CASE("Exclusion masks") {
+  SECTION("Masks hold airports and countries") {
+    ExclusionMask mask;
+    REQUIRE(mask.empty());
+    REQUIRE_FALSE(mask.excluded(100000));
+    mask.exclude(3);
+    mask.exclude(130);
+    mask.exclude(-1);
+    REQUIRE(mask.count() == 2);
+    REQUIRE(mask.excluded(130));
+    mask.allow(130);
+    REQUIRE((mask | ExclusionMask(10)).count() == 1);
+
+    auto g = Graph("tests/simpleAirport.csv", "tests/simpleRoute.csv");
+    REQUIRE(g.countryMask("Papua New Guinea").count() == 6);
+    REQUIRE(g.countryMask("Greenland").excluded(g.indexOf(8)));
+    REQUIRE(g.countryMask("Atlantis").empty());
+    REQUIRE(g.airportMask({2, 4, 999}).count() == 2);
+
+    REQUIRE(g.shortestPath(1, 5).found());
+    REQUIRE_FALSE(g.shortestPath(1, 5, PathAlgorithm::Dijkstra, g.airportMask({2})).found());
+    REQUIRE_FALSE(g.shortestPath(1, 5, PathAlgorithm::Dijkstra, g.airportMask({5})).found());
+    REQUIRE(g.shortestPath(2, 5, PathAlgorithm::Dijkstra, g.airportMask({3, 4})).path == vector<Vertex>{2, 5});
+  }
+
+  SECTION("Every engine avoids the mask and agrees with Dijkstra") {
+    auto g = Graph("assets/airports.csv", "assets/routes.csv", "assets/graph.snapshot");
+    vector<Vertex> airports{3830, 2990, 507, 1382, 3361, 4374, 3797, 3364};
+    vector<PathAlgorithm> algorithms{PathAlgorithm::Bidirectional, PathAlgorithm::AStar, PathAlgorithm::ALT,
+                                     PathAlgorithm::ContractionHierarchy, PathAlgorithm::HubLabels, PathAlgorithm::CachedTree};
+    for (Vertex source : airports) {
+      for (Vertex destination : airports) {
+        if (source == destination) continue;
+        // Close the airports the unrestricted route connects through, then whole countries on top
+        auto direct = g.shortestPath(source, destination, PathAlgorithm::Dijkstra);
+        vector<Vertex> stops(direct.path.begin() + 1, direct.path.end() - 1);
+        for (auto avoid : {g.airportMask(stops), g.countryMask("Russia") | g.countryMask("Germany") | g.airportMask(stops)}) {
+          auto expected = g.shortestPath(source, destination, PathAlgorithm::Dijkstra, avoid);
+          if (!stops.empty() && expected.found()) REQUIRE(expected.totalDistance >= direct.totalDistance);
+          for (PathAlgorithm algorithm : algorithms) {
+            auto result = g.shortestPath(source, destination, algorithm, avoid);
+            REQUIRE(result.totalDistance == expected.totalDistance);
+            for (Vertex airport : result.path) REQUIRE_FALSE(avoid.excluded(g.indexOf(airport)));
+          }
+        }
+      }
+    }
+
+    ThreadPool pool(2);
+    auto avoid = g.countryMask("United States");
+    auto batch = g.shortestPaths({{507, 1382}, {507, 3830}}, PathAlgorithm::Bidirectional, pool, avoid);
+    REQUIRE(batch[0].found());
+    REQUIRE_FALSE(batch[1].found());
+  }
+}
+
+TEST_CASE("Exclusion masks apply to every engine") {
+  // Close the first connection of the unrestricted route, so every engine has to route around it
+  auto g = Graph("assets/airports.csv", "assets/routes.csv", "assets/graph.snapshot");
+  Vertex source = 2990, destination = 3830;
+  auto direct = g.shortestPath(source, destination, PathAlgorithm::Dijkstra);
+  Vertex hub = direct.path[1];
+  auto avoid = g.airportMask({hub});
+  auto expected = g.shortestPath(source, destination, PathAlgorithm::Dijkstra, avoid);
+  REQUIRE(expected.found());
+  REQUIRE(expected.totalDistance > direct.totalDistance);
+  auto avoids = [&](const vector<Vertex>& path) { return std::find(path.begin(), path.end(), hub) == path.end(); };
+
+  SECTION("Hop-limited shortest paths") {
+    auto result = g.shortestPathWithStops(source, destination, INT_MAX, avoid);
+    REQUIRE(result.totalDistance == expected.totalDistance);
+    REQUIRE(avoids(result.path));
+    REQUIRE(g.shortestPathWithStops(source, destination, INT_MAX).totalDistance == direct.totalDistance);
+    REQUIRE_FALSE(g.shortestPathWithStops(source, hub, INT_MAX, avoid).found());
+
+    ThreadPool pool(2);
+    auto batch = g.shortestPathsWithStops({{source, destination}}, INT_MAX, pool, avoid);
+    REQUIRE(batch[0].totalDistance == expected.totalDistance);
+  }
+
+  SECTION("Pareto routes") {
+    auto routes = g.paretoRoutes(source, destination, INT_MAX, avoid);
+    REQUIRE_FALSE(routes.empty());
+    REQUIRE(routes.back().distance == expected.totalDistance);
+    for (auto& route : routes) REQUIRE(avoids(route.path));
+    REQUIRE(g.paretoRoutes(source, destination).back().distance == direct.totalDistance);
+  }
+
+  SECTION("K shortest paths") {
+    auto routes = g.kShortestPaths(source, destination, 5, avoid);
+    REQUIRE(routes.size() == 5);
+    REQUIRE(routes[0].totalDistance == expected.totalDistance);
+    for (auto& route : routes) REQUIRE(avoids(route.path));
+    REQUIRE(g.kShortestPaths(source, destination, 1)[0].totalDistance == direct.totalDistance);
+  }
+
+  SECTION("Breadth-first search") {
+    ThreadPool pool(2);
+    auto open = g.hopTree(source);
+    auto closed = g.hopTree(source, nullptr, avoid);
+    auto parallel = g.hopTree(source, &pool, avoid);
+    int h = g.indexOf(hub), rerouted = 0, reached = 0;
+    REQUIRE(open.reached(h));
+    REQUIRE_FALSE(closed.reached(h));
+    for (int v = 0; v < (int) closed.hops.size(); v++) {
+      REQUIRE(closed.hops[v] == parallel.hops[v]);
+      if (!closed.reached(v)) continue;
+      reached++;
+      REQUIRE(closed.hops[v] >= open.hops[v]);
+      REQUIRE(closed.parent[v] != h);
+      rerouted += open.parent[v] == h;
+    }
+    REQUIRE(rerouted > 0);
+
+    auto order = g.BFS(source, avoid);
+    REQUIRE((int) order.size() == reached);
+    for (auto& airport : order) REQUIRE(airport.getCode() != hub);
+  }
+
+  SECTION("Distance matrix") {
+    vector<Vertex> sources{source, destination, hub}, targets{destination, source, 4374, hub};
+    auto matrix = g.distanceMatrix(sources, targets, avoid);
+    for (size_t i = 0; i < sources.size(); i++)
+      for (size_t j = 0; j < targets.size(); j++)
+        REQUIRE(matrix[i * targets.size() + j] == g.shortestPath(sources[i], targets[j], PathAlgorithm::Dijkstra, avoid).totalDistance);
+    REQUIRE(g.distanceMatrix({source}, {destination})[0] == direct.totalDistance);
+  }
+
+  SECTION("Shortest distance") {
+    REQUIRE(g.shortestDistance(source, destination, avoid) == expected.totalDistance);
+    REQUIRE(g.shortestDistance(source, hub, avoid) == INT_MAX);
+    REQUIRE(g.shortestDistance(source, destination) == direct.totalDistance);
+  }
+}
+
+TEST_CASE("Query server answers over a Unix socket") {
+  auto g = Graph("tests/simpleAirDij.csv", "tests/simpleRouDij.csv");
+
+  SECTION("Query lines") {
+    SearchWorkspace workspace;
+    g.prepare(PathAlgorithm::Bidirectional);
+    REQUIRE(QueryServer::answer(g, "1 4", PathAlgorithm::Bidirectional, workspace) == "OK 566 1 2 3 4\n");
+    REQUIRE(QueryServer::answer(g, "  GKA\tlae ", PathAlgorithm::Bidirectional, workspace) == "OK 566 1 2 3 4\n");
+    REQUIRE(QueryServer::answer(g, "4 1", PathAlgorithm::Bidirectional, workspace) == "NONE\n");
+    REQUIRE(QueryServer::answer(g, "1 XYZ", PathAlgorithm::Bidirectional, workspace) == "ERROR unknown airport XYZ\n");
+    REQUIRE(QueryServer::answer(g, "1", PathAlgorithm::Bidirectional, workspace).compare(0, 6, "ERROR ") == 0);
+  }
+
+  SECTION("Pipelined queries come back in order") {
+    ThreadPool pool(2);
+    QueryServer server(g, pool, PathAlgorithm::Dijkstra);
+    server.listen("tests/test_server.sock");
+    std::thread loop([&]() { server.run(); });
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, "tests/test_server.sock");
+    REQUIRE(connect(fd, (sockaddr*) &address, sizeof(address)) == 0);
+
+    // The second query is split across writes and only completes with the third
+    string first = "1 3\n2 ", second = "4\r\n1 1\nbad\n";
+    REQUIRE(write(fd, first.data(), first.size()) == (ssize_t) first.size());
+    usleep(20000);
+    REQUIRE(write(fd, second.data(), second.size()) == (ssize_t) second.size());
+    shutdown(fd, SHUT_WR);
+
+    string replies;
+    char buffer[256];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) replies.append(buffer, n);
+    close(fd);
+    REQUIRE(replies == "OK 285 1 2 3\nOK 460 2 3 4\nOK 0 1\nERROR expected \"<from> <to>\"\n");
+
+    server.stop();
+    loop.join();
+    REQUIRE(server.answered() == 4);
+  }
+
+  SECTION("A line that is too long closes the connection after the replies before it") {
+    ThreadPool pool(2);
+    QueryServer server(g, pool);
+    server.listen("tests/test_server.sock");
+    std::thread loop([&]() { server.run(); });
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, "tests/test_server.sock");
+    REQUIRE(connect(fd, (sockaddr*) &address, sizeof(address)) == 0);
+
+    // The connection stays open for writing, so only the server can end it
+    string request = "1 4\n" + string(10000, 'x');
+    REQUIRE(write(fd, request.data(), request.size()) == (ssize_t) request.size());
+
+    string replies;
+    char buffer[256];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) replies.append(buffer, n);
+    close(fd);
+    REQUIRE(replies == "OK 566 1 2 3 4\nERROR query line is too long\n");
+
+    server.stop();
+    loop.join();
+  }
+}
+
+TEST_CASE("Batch queries stream from a file") {
+  auto g = Graph("tests/simpleAirDij.csv", "tests/simpleRouDij.csv");
+  ThreadPool pool(2);
+  string input = "1 4\n\nGKA,HGU\r\n4 1\nXYZ 1\n1 2 3\n";
+
+  SECTION("CSV in input order") {
+    std::istringstream in(input);
+    std::ostringstream out;
+    BatchStats stats = runBatch(g, in, out, pool);
+    REQUIRE(out.str() ==
+      "line,from,to,status,distance_km,path\n"
+      "1,1,4,ok,566,1 2 3 4\n"
+      "3,GKA,HGU,ok,285,1 2 3\n"
+      "4,4,1,none,,\n"
+      "5,XYZ,1,error,,unknown airport XYZ\n"
+      "6,1,2,error,,expected <from> <to>\n");
+    REQUIRE(stats.queries == 5);
+    REQUIRE(stats.found == 2);
+    REQUIRE(stats.unreachable == 1);
+    REQUIRE(stats.errors == 2);
+  }
+
+  SECTION("JSONL, unordered, in small chunks") {
+    BatchOptions options;
+    options.format = BatchOptions::Format::JSONL;
+    options.ordered = false;
+    options.chunk = 2;
+    options.algorithm = PathAlgorithm::Dijkstra;
+    string many;
+    for (int i = 0; i < 50; i++) many += input;
+    std::istringstream in(many);
+    std::ostringstream out;
+    BatchStats stats = runBatch(g, in, out, pool, options);
+    REQUIRE(stats.queries == 250);
+
+    // Every line comes out once, whatever the order
+    std::istringstream records(out.str());
+    vector<string> lines;
+    string record;
+    while (std::getline(records, record)) lines.push_back(record);
+    REQUIRE(lines.size() == 250);
+    int found = 0;
+    for (auto& line : lines) found += line.find("\"status\":\"ok\"") != string::npos;
+    REQUIRE(found == 100);
+    REQUIRE(std::count(lines.begin(), lines.end(), "{\"line\":1,\"from\":\"1\",\"to\":\"4\",\"status\":\"ok\",\"distance_km\":566,\"path\":[1,2,3,4]}") == 1);
+    REQUIRE(std::count(lines.begin(), lines.end(), "{\"line\":34,\"from\":\"4\",\"to\":\"1\",\"status\":\"none\"}") == 1);
+  }
+}